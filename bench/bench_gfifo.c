@@ -0,0 +1,376 @@
+
+#define _GNU_SOURCE
+#include "gfifo.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Throughput and latency benchmark for the gfifo variants.
+ *
+ * Measures, for every element size and capacity:
+ *   - scalar push/pop (push then pop one element)
+ *   - bulk push_array/pop_array in batches of BULK_BATCH elements
+ *   - 2-thread SPSC streaming throughput (atomic variants)
+ * and a 2-thread SPSC ping-pong round trip latency (p50/p99/p999).
+ *
+ * Results are printed as CSV (one line per measurement) to stdout or to the
+ * file given with -o, so runs can be diffed and tracked for regressions.
+ *
+ * usage: bench_gfifo [-o file.csv] [-s scale] [-c cpu0,cpu1]
+ */
+
+#define BULK_BATCH (32)
+#define PINGPONG_ROUNDS (20000)
+#define MAX_BUF_BYTES (64u * 1024u * 1024u)
+#define SPIN_BEFORE_YIELD (1024)
+
+typedef struct { uint8_t b[1]; } elem1_t;
+typedef struct { uint8_t b[8]; } elem8_t;
+typedef struct { uint8_t b[64]; } elem64_t;
+typedef struct { uint8_t b[256]; } elem256_t;
+
+DECLARE_GFIFO_TYPE(plain_e1, elem1_t);
+DECLARE_GFIFO_TYPE(plain_e8, elem8_t);
+DECLARE_GFIFO_TYPE(plain_e64, elem64_t);
+DECLARE_GFIFO_TYPE(plain_e256, elem256_t);
+DECLARE_GFIFO_TYPE_ATOMIC(atomic_e1, elem1_t);
+DECLARE_GFIFO_TYPE_ATOMIC(atomic_e8, elem8_t);
+DECLARE_GFIFO_TYPE_ATOMIC(atomic_e64, elem64_t);
+DECLARE_GFIFO_TYPE_ATOMIC(atomic_e256, elem256_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL(atomic_cl_e1, elem1_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL(atomic_cl_e8, elem8_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL(atomic_cl_e64, elem64_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL(atomic_cl_e256, elem256_t);
+
+DECLARE_GFIFO_TYPE_ATOMIC_CL(ping, uint64_t);
+
+static const uint32_t capacities[] = {64, 1024, 65536, 1048576};
+
+static FILE *out;
+static double scale = 1.0;
+static int cpus[2] = {-1, -1};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void pin_self(int cpu)
+{
+    if (cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+}
+
+static void backoff(uint32_t *spins)
+{
+    if (++*spins >= SPIN_BEFORE_YIELD)
+    {
+        *spins = 0;
+        sched_yield();
+    }
+    else
+    {
+        GFIFO_CPU_RELAX();
+    }
+}
+
+static void die(const char *what)
+{
+    fprintf(stderr, "bench_gfifo: %s failed\n", what);
+    exit(1);
+}
+
+static void *xmalloc(size_t size)
+{
+    void *p = malloc(size);
+    if (p == NULL)
+    {
+        die("malloc");
+    }
+    return p;
+}
+
+static uint64_t scaled(uint64_t n)
+{
+    uint64_t v = (uint64_t)((double)n * scale);
+    return v ? v : 1;
+}
+
+static void report(const char *variant, const char *op, size_t esz,
+                   uint32_t cap, uint64_t ops, uint64_t ns)
+{
+    double nspo = (double)ns / (double)ops;
+    fprintf(out, "%s,%s,%zu,%u,%llu,%.2f,%.2f,,,\n", variant, op, esz, cap,
+            (unsigned long long)ops, nspo, 1000.0 / nspo);
+}
+
+/* total bytes moved per measurement, so big elements do not run forever */
+#define BYTES_PER_RUN (64ull * 1024 * 1024)
+
+#define DEFINE_BENCH(variant, etype)                                           \
+    static void bench_single_##variant(uint32_t cap)                           \
+    {                                                                          \
+        gfifo_##variant##_t f;                                                 \
+        etype *buf = xmalloc((size_t)cap * sizeof(etype));                     \
+        etype arr[BULK_BATCH];                                                 \
+        etype e;                                                               \
+        uint64_t ops = scaled(BYTES_PER_RUN / sizeof(etype));                  \
+        uint32_t fill = cap < BULK_BATCH ? cap : BULK_BATCH;                   \
+        uint64_t t0, k;                                                        \
+        memset(arr, 0x5a, sizeof(arr));                                        \
+        memset(&e, 0x5a, sizeof(e));                                           \
+        if (!gfifo_##variant##_init(&f, buf, cap))                             \
+        {                                                                      \
+            die(#variant "_init");                                             \
+        }                                                                      \
+        /* keep the ring half full so indices keep wrapping over buf */        \
+        for (k = 0; k < cap / 2; k++)                                          \
+        {                                                                      \
+            gfifo_##variant##_push(&f, &e);                                    \
+        }                                                                      \
+        t0 = now_ns();                                                         \
+        for (k = 0; k < ops; k++)                                              \
+        {                                                                      \
+            gfifo_##variant##_push(&f, &e);                                    \
+            gfifo_##variant##_pop(&f, &e);                                     \
+        }                                                                      \
+        report(#variant, "scalar", sizeof(etype), cap, ops, now_ns() - t0);    \
+        gfifo_##variant##_reset(&f);                                           \
+        t0 = now_ns();                                                         \
+        for (k = 0; k < ops; k += fill)                                        \
+        {                                                                      \
+            gfifo_##variant##_push_array(&f, arr, fill);                       \
+            gfifo_##variant##_pop_array(&f, arr, fill);                        \
+        }                                                                      \
+        report(#variant, "bulk", sizeof(etype), cap, k, now_ns() - t0);        \
+        free(buf);                                                             \
+    }                                                                          \
+                                                                               \
+    typedef struct                                                             \
+    {                                                                          \
+        gfifo_##variant##_t *f;                                                \
+        uint64_t ops;                                                          \
+    } spsc_##variant##_arg_t;                                                  \
+                                                                               \
+    static void *spsc_prod_##variant(void *p)                                  \
+    {                                                                          \
+        spsc_##variant##_arg_t *a = p;                                         \
+        etype e;                                                               \
+        uint32_t spins = 0;                                                    \
+        memset(&e, 0x5a, sizeof(e));                                           \
+        pin_self(cpus[1]);                                                     \
+        for (uint64_t k = 0; k < a->ops;)                                      \
+        {                                                                      \
+            if (gfifo_##variant##_push(a->f, &e))                              \
+            {                                                                  \
+                k++;                                                           \
+            }                                                                  \
+            else                                                               \
+            {                                                                  \
+                backoff(&spins);                                               \
+            }                                                                  \
+        }                                                                      \
+        return NULL;                                                           \
+    }                                                                          \
+                                                                               \
+    static void bench_spsc_##variant(uint32_t cap)                             \
+    {                                                                          \
+        gfifo_##variant##_t f;                                                 \
+        etype *buf = xmalloc((size_t)cap * sizeof(etype));                     \
+        spsc_##variant##_arg_t a = {&f, scaled(BYTES_PER_RUN / 4 /             \
+                                               sizeof(etype))};                \
+        pthread_t t;                                                           \
+        uint32_t spins = 0;                                                    \
+        etype e;                                                               \
+        if (!gfifo_##variant##_init(&f, buf, cap))                             \
+        {                                                                      \
+            die(#variant "_init");                                             \
+        }                                                                      \
+        uint64_t t0 = now_ns();                                                \
+        pthread_create(&t, NULL, spsc_prod_##variant, &a);                     \
+        for (uint64_t k = 0; k < a.ops;)                                       \
+        {                                                                      \
+            if (gfifo_##variant##_pop(&f, &e))                                 \
+            {                                                                  \
+                k++;                                                           \
+            }                                                                  \
+            else                                                               \
+            {                                                                  \
+                backoff(&spins);                                               \
+            }                                                                  \
+        }                                                                      \
+        pthread_join(t, NULL);                                                 \
+        report(#variant, "spsc", sizeof(etype), cap, a.ops, now_ns() - t0);    \
+        free(buf);                                                             \
+    }
+
+DEFINE_BENCH(plain_e1, elem1_t)
+DEFINE_BENCH(plain_e8, elem8_t)
+DEFINE_BENCH(plain_e64, elem64_t)
+DEFINE_BENCH(plain_e256, elem256_t)
+DEFINE_BENCH(atomic_e1, elem1_t)
+DEFINE_BENCH(atomic_e8, elem8_t)
+DEFINE_BENCH(atomic_e64, elem64_t)
+DEFINE_BENCH(atomic_e256, elem256_t)
+DEFINE_BENCH(atomic_cl_e1, elem1_t)
+DEFINE_BENCH(atomic_cl_e8, elem8_t)
+DEFINE_BENCH(atomic_cl_e64, elem64_t)
+DEFINE_BENCH(atomic_cl_e256, elem256_t)
+
+typedef struct
+{
+    void (*single)(uint32_t cap);
+    void (*spsc)(uint32_t cap);
+    size_t esz;
+} bench_entry_t;
+
+#define ENTRY(variant, etype, threaded)                                        \
+    {bench_single_##variant, (threaded) ? bench_spsc_##variant : NULL,         \
+     sizeof(etype)}
+
+static const bench_entry_t entries[] = {
+    ENTRY(plain_e1, elem1_t, 0),       ENTRY(plain_e8, elem8_t, 0),
+    ENTRY(plain_e64, elem64_t, 0),     ENTRY(plain_e256, elem256_t, 0),
+    ENTRY(atomic_e1, elem1_t, 1),      ENTRY(atomic_e8, elem8_t, 1),
+    ENTRY(atomic_e64, elem64_t, 1),    ENTRY(atomic_e256, elem256_t, 1),
+    ENTRY(atomic_cl_e1, elem1_t, 1),   ENTRY(atomic_cl_e8, elem8_t, 1),
+    ENTRY(atomic_cl_e64, elem64_t, 1), ENTRY(atomic_cl_e256, elem256_t, 1),
+};
+
+static gfifo_ping_t ping_q, pong_q;
+
+static void *pong_thread(void *p)
+{
+    uint64_t v;
+    uint32_t spins = 0;
+    uint32_t rounds = *(uint32_t *)p;
+    pin_self(cpus[1]);
+    for (uint32_t k = 0; k < rounds; k++)
+    {
+        while (!gfifo_ping_pop(&ping_q, &v))
+        {
+            backoff(&spins);
+        }
+        while (!gfifo_ping_push(&pong_q, &v))
+        {
+            backoff(&spins);
+        }
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench_pingpong(void)
+{
+    static uint64_t ping_buf[64];
+    static uint64_t pong_buf[64];
+    uint32_t rounds = (uint32_t)scaled(PINGPONG_ROUNDS);
+    uint64_t *rtt = xmalloc(rounds * sizeof(uint64_t));
+    uint32_t spins = 0;
+    pthread_t t;
+    uint64_t v;
+
+    if (!gfifo_ping_init(&ping_q, ping_buf, 64) ||
+        !gfifo_ping_init(&pong_q, pong_buf, 64))
+    {
+        die("ping_init");
+    }
+    pthread_create(&t, NULL, pong_thread, &rounds);
+    for (uint32_t k = 0; k < rounds; k++)
+    {
+        uint64_t t0 = now_ns();
+        while (!gfifo_ping_push(&ping_q, &t0))
+        {
+            backoff(&spins);
+        }
+        while (!gfifo_ping_pop(&pong_q, &v))
+        {
+            backoff(&spins);
+        }
+        rtt[k] = now_ns() - v;
+    }
+    pthread_join(t, NULL);
+
+    qsort(rtt, rounds, sizeof(uint64_t), cmp_u64);
+    fprintf(out, "atomic_cl_e8,pingpong,8,64,%u,,,%llu,%llu,%llu\n", rounds,
+            (unsigned long long)rtt[rounds / 2],
+            (unsigned long long)rtt[(uint64_t)rounds * 99 / 100],
+            (unsigned long long)rtt[(uint64_t)rounds * 999 / 1000]);
+    free(rtt);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    out = stdout;
+    while ((opt = getopt(argc, argv, "o:s:c:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'o':
+            out = fopen(optarg, "w");
+            if (out == NULL)
+            {
+                perror(optarg);
+                return -1;
+            }
+            break;
+        case 's':
+            scale = atof(optarg);
+            break;
+        case 'c':
+            sscanf(optarg, "%d,%d", &cpus[0], &cpus[1]);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-o file.csv] [-s scale] [-c cpu0,cpu1]\n",
+                    argv[0]);
+            return -1;
+        }
+    }
+
+    pin_self(cpus[0]);
+    fprintf(out, "variant,op,elem_size,capacity,ops,ns_per_op,mops_per_s,"
+                 "p50_ns,p99_ns,p999_ns\n");
+    for (size_t k = 0; k < sizeof(entries) / sizeof(entries[0]); k++)
+    {
+        for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++)
+        {
+            if ((uint64_t)capacities[c] * entries[k].esz > MAX_BUF_BYTES)
+            {
+                continue;
+            }
+            entries[k].single(capacities[c]);
+            if (entries[k].spsc != NULL)
+            {
+                entries[k].spsc(capacities[c]);
+            }
+            fflush(out);
+        }
+    }
+    bench_pingpong();
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include "gfifo.h"
+#include "gfifo_mpmc.h"
+#include "gfifo_mpsc.h"
+#include "sfifo.h"
+
+/*
+ * Code size probe for the FIFO headers.
+ *
+ * Instantiates the main variants with a 4-byte element and nothing else.
+ * `make size` compiles this file with -fkeep-inline-functions, so every
+ * generated function gets an out-of-line copy in the object file, and
+ * lists them with their size in bytes. `make size_cortex_m` does the same
+ * with the Cortex-M cross compiler at -Os.
+ */
+
+DECLARE_GFIFO_TYPE(plain, uint32_t);
+DECLARE_GFIFO_TYPE_CL(plain_cl, uint32_t);
+#ifdef GFIFO_HAS_ISR
+DECLARE_GFIFO_TYPE_ISR(isr, uint32_t);
+#endif
+#ifdef GFIFO_HAS_ATOMICS
+DECLARE_GFIFO_TYPE_ATOMIC(atomic, uint32_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL(atomic_cl, uint32_t);
+DECLARE_GFIFO_MPSC_TYPE(mpsc, uint32_t);
+DECLARE_GFIFO_MPMC_TYPE(mpmc, uint32_t);
+#endif
+DECLARE_SFIFO_TYPE(static, uint32_t, 64);
+DECLARE_SFIFO_TYPE_CL(static_cl, uint32_t, 64);
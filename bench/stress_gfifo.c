@@ -0,0 +1,501 @@
+#define _GNU_SOURCE
+#define GFIFO_CFG_ISR_SMP
+#include "gfifo.h"
+#include "gfifo_mpmc.h"
+#include "gfifo_mpsc.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Multithreaded stress test for the concurrent gfifo variants.
+ *
+ * Every producer pushes the sequence (producer << 48) | 0, 1, 2, ... and
+ * every consumer checks what it pops:
+ *   - the producer id is in range and its sequence numbers only go up
+ *     (and go up by exactly one when there is a single consumer);
+ *   - the number of popped elements and the sum of a 64-bit mix of every
+ *     popped value match what the producers pushed.
+ * A lost, duplicated, torn or reordered element fails the run.
+ *
+ * The lossy variant overwrites the oldest elements instead of waiting, so
+ * its consumer accepts gaps in the sequence. Each value carries a hash of
+ * its sequence number in the upper 32 bits to catch torn copies, and the
+ * run fails unless pushed == popped + lost.
+ *
+ * Bulk variants push and pop batches of a random length in [1, MAX_BATCH],
+ * so the copies wrap around the end of the buffer at every offset. Small
+ * capacities (the default is 64) keep the FIFO switching between full and
+ * empty all the time.
+ *
+ * Results are printed as CSV, one line per variant. The exit status is 0
+ * only if all variants passed.
+ *
+ * usage: stress_gfifo [-n ops] [-p producers] [-c consumers] [-q capacity]
+ *                     [-t variant]
+ */
+
+#define DEFAULT_OPS (1ull << 24)
+#define DEFAULT_CAPACITY (64)
+#define MAX_CAPACITY (1u << 20)
+#define MAX_THREADS (16)
+#define MAX_BATCH (16)
+#define SEQ_BITS (48)
+#define SEQ_MASK ((1ull << SEQ_BITS) - 1)
+#define SPIN_BEFORE_YIELD (1024)
+
+DECLARE_GFIFO_TYPE_ATOMIC(atomic, uint64_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL(atomic_cl, uint64_t);
+#ifdef GFIFO_HAS_ISR
+DECLARE_GFIFO_TYPE_ISR(isr, uint64_t);
+#endif
+DECLARE_GFIFO_MPSC_TYPE(mpsc, uint64_t);
+DECLARE_GFIFO_MPMC_TYPE(mpmc, uint64_t);
+DECLARE_GFIFO_TYPE_LOSSY(lossy, uint64_t);
+
+static uint64_t ops = DEFAULT_OPS;
+static uint32_t capacity = DEFAULT_CAPACITY;
+static uint32_t producers = 2;
+static uint32_t consumers = 2;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void backoff(uint32_t *spins)
+{
+    if (++*spins >= SPIN_BEFORE_YIELD)
+    {
+        *spins = 0;
+        sched_yield();
+    }
+    else
+    {
+        GFIFO_CPU_RELAX();
+    }
+}
+
+/* splitmix64 finalizer, so that different corruptions do not cancel out */
+static uint64_t mix(uint64_t v)
+{
+    v ^= v >> 30;
+    v *= 0xbf58476d1ce4e5b9ull;
+    v ^= v >> 27;
+    v *= 0x94d049bb133111ebull;
+    return v ^ (v >> 31);
+}
+
+/* value of lossy sequence number seq, tagged with a hash of seq */
+static uint64_t seal(uint64_t seq)
+{
+    return seq | (mix(seq) & ~0xffffffffull);
+}
+
+static uint32_t next_rand(uint32_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+/*
+ * Variant adapters: push up to len elements and return how many were
+ * pushed, pop up to len elements and return how many were popped.
+ */
+static void *qbuf;
+static gfifo_atomic_t q_atomic;
+static gfifo_atomic_cl_t q_atomic_cl;
+#if defined(GFIFO_HAS_ISR) && !defined(__SANITIZE_THREAD__)
+static gfifo_isr_t q_isr;
+#endif
+static gfifo_mpsc_t q_mpsc;
+static gfifo_mpmc_t q_mpmc;
+static gfifo_lossy_t q_lossy;
+static _Atomic uint64_t lost;
+
+#define DEFINE_SCALAR(variant, q)                                              \
+    static bool init_##variant(void)                                           \
+    {                                                                          \
+        return gfifo_##variant##_init(&q, qbuf, capacity);                     \
+    }                                                                          \
+                                                                               \
+    static uint32_t push_##variant(const uint64_t *arr, uint32_t len)          \
+    {                                                                          \
+        (void)len;                                                             \
+        return gfifo_##variant##_push(&q, arr) ? 1 : 0;                        \
+    }                                                                          \
+                                                                               \
+    static uint32_t pop_##variant(uint64_t *arr, uint32_t len)                 \
+    {                                                                          \
+        (void)len;                                                             \
+        return gfifo_##variant##_pop(&q, arr) ? 1 : 0;                         \
+    }
+
+#define DEFINE_BULK(variant, q)                                                \
+    static uint32_t push_some_##variant(const uint64_t *arr, uint32_t len)     \
+    {                                                                          \
+        return gfifo_##variant##_push_some(&q, arr, len);                      \
+    }                                                                          \
+                                                                               \
+    static uint32_t pop_some_##variant(uint64_t *arr, uint32_t len)            \
+    {                                                                          \
+        return gfifo_##variant##_pop_some(&q, arr, len);                       \
+    }
+
+DEFINE_SCALAR(atomic, q_atomic)
+DEFINE_SCALAR(atomic_cl, q_atomic_cl)
+DEFINE_BULK(atomic_cl, q_atomic_cl)
+#if defined(GFIFO_HAS_ISR) && !defined(__SANITIZE_THREAD__)
+DEFINE_SCALAR(isr, q_isr)
+DEFINE_BULK(isr, q_isr)
+#endif
+DEFINE_SCALAR(mpsc, q_mpsc)
+DEFINE_SCALAR(mpmc, q_mpmc)
+
+/* all or nothing: the MPSC FIFO has no push_some() */
+static uint32_t push_array_mpsc(const uint64_t *arr, uint32_t len)
+{
+    return gfifo_mpsc_push_array(&q_mpsc, arr, len) ? len : 0;
+}
+
+static uint32_t pop_some_mpsc(uint64_t *arr, uint32_t len)
+{
+    return gfifo_mpsc_pop_some(&q_mpsc, arr, len);
+}
+
+static bool init_lossy(void)
+{
+    return gfifo_lossy_init(&q_lossy, qbuf, capacity);
+}
+
+/*
+ * Never fails and counts what it overwrote instead. Backs off after an
+ * overwrite like the other producers do when full, so the consumer still
+ * gets to pop (and race with the overwrites) on a loaded machine.
+ */
+static uint32_t push_overwrite_lossy(const uint64_t *arr, uint32_t len)
+{
+    static uint32_t spins;
+    uint32_t n = gfifo_lossy_push_array_overwrite(&q_lossy, arr, len);
+    if (n > 0)
+    {
+        atomic_fetch_add_explicit(&lost, n, memory_order_relaxed);
+        backoff(&spins);
+    }
+    return len;
+}
+
+static uint32_t pop_some_lossy(uint64_t *arr, uint32_t len)
+{
+    return gfifo_lossy_pop_some(&q_lossy, arr, len);
+}
+
+typedef struct
+{
+    const char *name;
+    bool multi_producer;
+    bool multi_consumer;
+    bool bulk;
+    bool lossy;
+    size_t slot_size;
+    bool (*init)(void);
+    uint32_t (*push)(const uint64_t *arr, uint32_t len);
+    uint32_t (*pop)(uint64_t *arr, uint32_t len);
+} variant_t;
+
+static const variant_t variants[] = {
+    {"atomic", false, false, false, false, sizeof(uint64_t), init_atomic,
+     push_atomic, pop_atomic},
+    {"atomic_cl", false, false, false, false, sizeof(uint64_t),
+     init_atomic_cl, push_atomic_cl, pop_atomic_cl},
+    {"atomic_cl_bulk", false, false, true, false, sizeof(uint64_t),
+     init_atomic_cl, push_some_atomic_cl, pop_some_atomic_cl},
+#if defined(GFIFO_HAS_ISR) && !defined(__SANITIZE_THREAD__)
+    /* volatile indices plus fences: correct, but invisible to TSan */
+    {"isr_smp", false, false, false, false, sizeof(uint64_t), init_isr,
+     push_isr, pop_isr},
+    {"isr_smp_bulk", false, false, true, false, sizeof(uint64_t), init_isr,
+     push_some_isr, pop_some_isr},
+#endif
+    {"mpsc", true, false, false, false, sizeof(uint64_t), init_mpsc,
+     push_mpsc, pop_mpsc},
+    {"mpsc_bulk", true, false, true, false, sizeof(uint64_t), init_mpsc,
+     push_array_mpsc, pop_some_mpsc},
+    {"mpmc", true, true, false, false, sizeof(gfifo_mpmc_slot_t), init_mpmc,
+     push_mpmc, pop_mpmc},
+    {"lossy", false, false, true, true, sizeof(uint64_t), init_lossy,
+     push_overwrite_lossy, pop_some_lossy},
+};
+
+typedef struct
+{
+    const variant_t *v;
+    uint32_t id;
+    uint64_t ops;
+    uint64_t sum;
+} producer_t;
+
+typedef struct
+{
+    const variant_t *v;
+    uint32_t nprod;
+    bool exact;
+    uint64_t next[MAX_THREADS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t errors;
+} consumer_t;
+
+static _Atomic uint64_t consumed;
+static uint64_t total;
+
+static void *producer_thread(void *p)
+{
+    producer_t *a = p;
+    uint64_t arr[MAX_BATCH];
+    uint64_t base = (uint64_t)a->id << SEQ_BITS;
+    uint32_t seed = 0x9e3779b9u ^ (a->id + 1) * 0x85ebca6bu;
+    uint32_t spins = 0;
+    uint64_t sum = 0;
+
+    for (uint64_t k = 0; k < a->ops;)
+    {
+        uint64_t left = a->ops - k;
+        uint32_t len = a->v->bulk ? next_rand(&seed) % MAX_BATCH + 1 : 1;
+        uint32_t n;
+        if (len > left)
+        {
+            len = (uint32_t)left;
+        }
+        for (uint32_t j = 0; j < len; j++)
+        {
+            arr[j] = a->v->lossy ? seal(k + j) : base | (k + j);
+        }
+        n = a->v->push(arr, len);
+        if (n == 0)
+        {
+            backoff(&spins);
+            continue;
+        }
+        for (uint32_t j = 0; j < n; j++)
+        {
+            sum += mix(arr[j]);
+        }
+        k += n;
+    }
+    a->sum = sum;
+    return NULL;
+}
+
+static void check(consumer_t *a, uint64_t v)
+{
+    uint64_t id = v >> SEQ_BITS;
+    uint64_t seq = v & SEQ_MASK;
+
+    if (a->v->lossy)
+    {
+        id = 0;
+        seq = v & 0xffffffffull;
+    }
+    a->sum += mix(v);
+    if (id >= a->nprod || (a->v->lossy && v != seal(seq)))
+    {
+        if (a->errors++ == 0)
+        {
+            fprintf(stderr, "%s: torn value %016llx\n", a->v->name,
+                    (unsigned long long)v);
+        }
+    }
+    else if (a->exact ? seq != a->next[id] : seq < a->next[id])
+    {
+        if (a->errors++ == 0)
+        {
+            fprintf(stderr, "%s: producer %u: got %llu, expected %s%llu\n",
+                    a->v->name, (unsigned)id, (unsigned long long)seq,
+                    a->exact ? "" : ">= ", (unsigned long long)a->next[id]);
+        }
+        a->next[id] = seq + 1;
+    }
+    else
+    {
+        a->next[id] = seq + 1;
+    }
+}
+
+static void *consumer_thread(void *p)
+{
+    consumer_t *a = p;
+    uint64_t arr[MAX_BATCH];
+    uint32_t seed = 0x2545f491u;
+    uint32_t spins = 0;
+
+    while (atomic_load_explicit(&consumed, memory_order_relaxed) +
+               atomic_load_explicit(&lost, memory_order_relaxed) <
+           total)
+    {
+        uint32_t len = a->v->bulk ? next_rand(&seed) % MAX_BATCH + 1 : 1;
+        uint32_t n = a->v->pop(arr, len);
+        if (n == 0)
+        {
+            backoff(&spins);
+            continue;
+        }
+        for (uint32_t j = 0; j < n; j++)
+        {
+            check(a, arr[j]);
+        }
+        a->count += n;
+        atomic_fetch_add_explicit(&consumed, n, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+static bool run(const variant_t *v)
+{
+    pthread_t prod_t[MAX_THREADS], cons_t[MAX_THREADS];
+    producer_t prod[MAX_THREADS];
+    consumer_t cons[MAX_THREADS];
+    uint32_t np = v->multi_producer ? producers : 1;
+    uint32_t nc = v->multi_consumer ? consumers : 1;
+    uint64_t pushed_sum = 0, popped_sum = 0, popped = 0, errors = 0;
+    uint64_t n_lost;
+    uint64_t t0, ns;
+    bool ok;
+
+    if (v->lossy && ops > 0xffffffffull)
+    {
+        fprintf(stderr, "%s: at most 2^32 - 1 ops\n", v->name);
+        return false;
+    }
+    qbuf = malloc((size_t)capacity * v->slot_size);
+    if (qbuf == NULL || !v->init())
+    {
+        fprintf(stderr, "%s: cannot create FIFO of %u\n", v->name, capacity);
+        free(qbuf);
+        return false;
+    }
+    total = 0;
+    for (uint32_t k = 0; k < np; k++)
+    {
+        prod[k] = (producer_t){v, k, ops / np + (k < ops % np), 0};
+        total += prod[k].ops;
+    }
+    atomic_store(&consumed, 0);
+    atomic_store(&lost, 0);
+
+    t0 = now_ns();
+    for (uint32_t k = 0; k < nc; k++)
+    {
+        memset(&cons[k], 0, sizeof(cons[k]));
+        cons[k].v = v;
+        cons[k].nprod = np;
+        cons[k].exact = nc == 1 && !v->lossy;
+        pthread_create(&cons_t[k], NULL, consumer_thread, &cons[k]);
+    }
+    for (uint32_t k = 0; k < np; k++)
+    {
+        pthread_create(&prod_t[k], NULL, producer_thread, &prod[k]);
+    }
+    for (uint32_t k = 0; k < np; k++)
+    {
+        pthread_join(prod_t[k], NULL);
+        pushed_sum += prod[k].sum;
+    }
+    for (uint32_t k = 0; k < nc; k++)
+    {
+        pthread_join(cons_t[k], NULL);
+        popped_sum += cons[k].sum;
+        popped += cons[k].count;
+        errors += cons[k].errors;
+    }
+    ns = now_ns() - t0;
+    free(qbuf);
+
+    /* the lossy variant cannot checksum, what it did not pop was lost */
+    n_lost = atomic_load(&lost);
+    if (v->lossy)
+    {
+        ok = errors == 0 && popped + n_lost == total;
+    }
+    else
+    {
+        ok = errors == 0 && popped == total && popped_sum == pushed_sum;
+    }
+    if (!ok)
+    {
+        fprintf(stderr,
+                "%s: %llu sequence errors, popped %llu + lost %llu of %llu, "
+                "checksum %016llx != %016llx\n",
+                v->name, (unsigned long long)errors,
+                (unsigned long long)popped, (unsigned long long)n_lost,
+                (unsigned long long)total, (unsigned long long)popped_sum,
+                (unsigned long long)pushed_sum);
+    }
+    printf("%s,%u,%u,%u,%llu,%.2f,%.2f,%s\n", v->name, np, nc, capacity,
+           (unsigned long long)total, total ? (double)ns / (double)total : 0.0,
+           ns ? (double)total * 1000.0 / (double)ns : 0.0, ok ? "ok" : "FAIL");
+    fflush(stdout);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *only = NULL;
+    int failed = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:p:c:q:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            ops = (uint64_t)strtod(optarg, NULL);
+            break;
+        case 'p':
+            producers = (uint32_t)atoi(optarg);
+            break;
+        case 'c':
+            consumers = (uint32_t)atoi(optarg);
+            break;
+        case 'q':
+            capacity = (uint32_t)atoi(optarg);
+            break;
+        case 't':
+            only = optarg;
+            break;
+        default:
+            fprintf(stderr,
+                    "usage: %s [-n ops] [-p producers] [-c consumers] "
+                    "[-q capacity] [-t variant]\n",
+                    argv[0]);
+            return -1;
+        }
+    }
+    if (producers < 1 || producers > MAX_THREADS || consumers < 1 ||
+        consumers > MAX_THREADS || capacity > MAX_CAPACITY ||
+        ops / producers > SEQ_MASK)
+    {
+        fprintf(stderr, "%s: -p/-c in [1, %d], -q up to %u\n", argv[0],
+                MAX_THREADS, MAX_CAPACITY);
+        return -1;
+    }
+
+    printf("variant,producers,consumers,capacity,ops,ns_per_op,mops_per_s,"
+           "result\n");
+    for (size_t k = 0; k < sizeof(variants) / sizeof(variants[0]); k++)
+    {
+        if (only == NULL || strcmp(only, variants[k].name) == 0)
+        {
+            failed += !run(&variants[k]);
+        }
+    }
+    return failed ? 1 : 0;
+}
@@ -20,7 +20,7 @@ const char *file_name = "demo_gfifo.txt";
 
 gfifo_byte_t fifo;
 
-int main(int argc, char *argv[])
+int main(void)
 {
     FILE *fd = fopen(file_name, "w");
     gfifo_byte_init(&fifo, fifo_buf, FIFO_SIZE);
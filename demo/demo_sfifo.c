@@ -17,7 +17,7 @@ sfifo_byte_1024_t fifo;
 
 const char *file_name = "demo_sfifo.txt";
 
-int main(int argc, char *argv[])
+int main(void)
 {
     FILE *fd = fopen(file_name, "w");
     sfifo_byte_1024_init(&fifo);
@@ -9,9 +9,33 @@
  *   - push/pop/drop
  *   - peek/peek_at
  *   - bulk push/pop with wrap-around handling
+ *   - partial bulk push/pop (push_some/pop_some)
+ *   - in-place batch push/pop via callbacks (push_batch/pop_batch)
+ *   - zero-copy push via push_reserve/push_commit
+ *   - zero-copy pop via readable_spans/release
+ *   - overwrite-oldest push for the lossy variant
+ *   - optional hot-path statistics (GFIFO_CFG_STATS)
+ *   - optional queueing delay histogram (GFIFO_CFG_LATENCY)
  *
  * Designed for SPSC usage with power-of-two capacity.
  *
+ * Four memory modes are available:
+ *   - DECLARE_GFIFO_TYPE():        volatile indices, for single-core and
+ *                                  ISR-to-task usage.
+ *   - DECLARE_GFIFO_TYPE_ATOMIC(): C11 atomic indices with acquire/release
+ *                                  publication, for cross-core SPSC usage.
+ *   - DECLARE_GFIFO_TYPE_LOSSY():  atomic indices where the producer may
+ *                                  overwrite the oldest elements instead of
+ *                                  failing when full (telemetry rings).
+ *   - DECLARE_GFIFO_TYPE_ISR():    plain indices with compiler barriers at
+ *                                  the publish points, for ISR-to-task
+ *                                  usage on MCUs.
+ *
+ * Only the PLAIN and ATOMIC modes also come with a cache-line separated
+ * layout (the *_CL variants) that keeps producer and consumer state on
+ * different lines. They and the ISR mode have *_EX variants with a custom
+ * index type; LOSSY always uses uint32_t.
+ *
  * @author
  *   Disen-Shaw <DisenShaw@gmail.com>
  * @date
@@ -26,6 +50,518 @@
 #include <stdint.h>
 #include <string.h>
 
+#if !defined(__cplusplus) && defined(__STDC_VERSION__) &&                      \
+    __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define GFIFO_HAS_ATOMICS 1
+#endif
+
+/*
+ * Index storage and access primitives for each memory mode.
+ *
+ * PLAIN  : volatile indices, memory order arguments are ignored.
+ * ATOMIC : C11 atomics, memory order arguments are honoured.
+ * LOSSY  : as ATOMIC, but the producer may also advance o, so the consumer
+ *          commits o with a CAS and retries its copy when it fails.
+ * ISR    : plain indices accessed through volatile casts only where they
+ *          are read or published, with GFIFO_ISR_BARRIER() after acquire
+ *          loads and before release stores (GNU C).
+ *
+ * __GFIFO_CONS_ST_<mode>(p, out, v) publishes the consumer index moving
+ * from `out` to `v` and yields false when `out` is no longer current.
+ */
+#define __GFIFO_IDX_PLAIN(t) volatile t
+#define __GFIFO_LD_PLAIN(p, mo) (*(p))
+#define __GFIFO_ST_PLAIN(p, v, mo) (*(p) = (v))
+#define __GFIFO_CONS_ST_PLAIN(p, out, v) (__GFIFO_ST_PLAIN(p, v, release), true)
+
+#ifdef GFIFO_HAS_ATOMICS
+#define __GFIFO_IDX_ATOMIC(t) _Atomic t
+#define __GFIFO_LD_ATOMIC(p, mo) atomic_load_explicit((p), memory_order_##mo)
+#define __GFIFO_ST_ATOMIC(p, v, mo)                                            \
+  atomic_store_explicit((p), (v), memory_order_##mo)
+#define __GFIFO_CONS_ST_ATOMIC(p, out, v)                                      \
+  (__GFIFO_ST_ATOMIC(p, v, release), true)
+
+#define __GFIFO_IDX_LOSSY(t) _Atomic t
+#define __GFIFO_LD_LOSSY(p, mo) __GFIFO_LD_ATOMIC(p, mo)
+#define __GFIFO_ST_LOSSY(p, v, mo) __GFIFO_ST_ATOMIC(p, v, mo)
+#define __GFIFO_CONS_ST_LOSSY(p, out, v)                                       \
+  atomic_compare_exchange_strong_explicit(                                     \
+      (p), &(out), (v), memory_order_release, memory_order_relaxed)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+/**
+ * @brief Ordering barrier of the ISR memory mode.
+ *
+ * A compiler-only barrier by default, which is sufficient between an ISR
+ * and thread code on the same core. Define GFIFO_CFG_ISR_SMP to use a DMB
+ * (or a full fence on other CPUs) when producer and consumer may run on
+ * different cores, or override the hook before including this header.
+ */
+#ifndef GFIFO_ISR_BARRIER
+#if defined(GFIFO_CFG_ISR_SMP) && (defined(__arm__) || defined(__aarch64__))
+#define GFIFO_ISR_BARRIER() __asm__ volatile("dmb ish" ::: "memory")
+#elif defined(GFIFO_CFG_ISR_SMP)
+#define GFIFO_ISR_BARRIER() __sync_synchronize()
+#else
+#define GFIFO_ISR_BARRIER() __asm__ volatile("" ::: "memory")
+#endif
+#endif
+
+static inline void __gfifo_isr_barrier(void) { GFIFO_ISR_BARRIER(); }
+static inline uintmax_t __gfifo_isr_acquire(uintmax_t v) {
+  GFIFO_ISR_BARRIER();
+  return v;
+}
+
+#define __GFIFO_ISR_VOL(p) (*(volatile __typeof__(*(p)) *)(p))
+#define __GFIFO_IDX_ISR(t) t
+#define __GFIFO_LD_ISR(p, mo) __GFIFO_LD_ISR_##mo(p)
+#define __GFIFO_LD_ISR_relaxed(p) __GFIFO_ISR_VOL(p)
+#define __GFIFO_LD_ISR_acquire(p)                                              \
+  ((__typeof__(*(p)))__gfifo_isr_acquire(__GFIFO_ISR_VOL(p)))
+#define __GFIFO_ST_ISR(p, v, mo) __GFIFO_ST_ISR_##mo(p, v)
+#define __GFIFO_ST_ISR_relaxed(p, v) (__GFIFO_ISR_VOL(p) = (v))
+#define __GFIFO_ST_ISR_release(p, v)                                           \
+  (__gfifo_isr_barrier(), __GFIFO_ISR_VOL(p) = (v))
+#define __GFIFO_CONS_ST_ISR(p, out, v) (__GFIFO_ST_ISR(p, v, release), true)
+#define GFIFO_HAS_ISR 1
+#endif
+
+/**
+ * @brief Cache line size used by the *_CL layouts.
+ *
+ * Override before including this header for targets with a larger
+ * destructive interference size (e.g. 128 on some ARM64 and POWER cores).
+ */
+#ifndef GFIFO_CACHELINE
+#define GFIFO_CACHELINE 64
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define __GFIFO_ALIGNED(n) _Alignas(n)
+#else
+#define __GFIFO_ALIGNED(n) __attribute__((aligned(n)))
+#endif
+
+/**
+ * @brief Copy routine used by the bulk operations (push_array, pop_array,
+ *        push_some, pop_some, ...).
+ *
+ * Override before including this header, e.g. with gfifo_copy() from
+ * gfifo_copy.h for non-temporal copies of large bursts, or with a DMA
+ * backed routine on MCUs. Must have memcpy() semantics.
+ */
+#ifndef GFIFO_MEMCPY
+#define GFIFO_MEMCPY(dst, src, n) memcpy((dst), (src), (n))
+#endif
+
+/**
+ * @brief CPU hint used inside spin-wait loops of the concurrent variants.
+ *
+ * Override before including this header to use a target specific hint.
+ */
+#ifndef GFIFO_CPU_RELAX
+#if defined(__x86_64__) || defined(__i386__)
+#define GFIFO_CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define GFIFO_CPU_RELAX() __asm__ volatile("yield" ::: "memory")
+#else
+#define GFIFO_CPU_RELAX() ((void)0)
+#endif
+#endif
+
+/* Index of the lowest set bit of a non-zero 64-bit mask. */
+#if defined(__GNUC__) || defined(__clang__)
+#define __GFIFO_CTZ64(x) ((uint32_t)__builtin_ctzll(x))
+#else
+static inline uint32_t __gfifo_ctz64(uint64_t x) {
+  uint32_t k = 0;
+  while ((x & 1) == 0) {
+    x >>= 1;
+    k++;
+  }
+  return k;
+}
+#define __GFIFO_CTZ64(x) __gfifo_ctz64(x)
+#endif
+
+/**
+ * @brief Snapshot of the optional hot-path statistics of a FIFO.
+ *
+ * Filled by gfifo_<name>_stats() when GFIFO_CFG_STATS is defined before
+ * including this header. Byte counters are element counters multiplied by
+ * sizeof(type).
+ */
+typedef struct {
+  uint64_t pushes;    /**< Elements pushed. */
+  uint64_t push_fail; /**< Push calls that found too little free space. */
+  uint64_t bytes_in;  /**< Bytes pushed. */
+  uint64_t lost;      /**< Elements overwritten (lossy variant only). */
+  uint64_t hwm;       /**< Highest count() seen right after a push. */
+  uint64_t pops;      /**< Elements popped, dropped or released. */
+  uint64_t pop_empty; /**< Pop calls that found too few elements. */
+  uint64_t bytes_out; /**< Bytes popped, dropped or released. */
+} gfifo_stats_t;
+
+/*
+ * Optional statistics (GFIFO_CFG_STATS), compiled out by default.
+ *
+ * The st_* fields of each side are only ever written by that side, and are
+ * placed next to its index (CL) or on a line of their own (PACKED), so the
+ * counters never add sharing between producer and consumer. The high
+ * watermark is only refreshed (one extra load of o) when the producer's own
+ * view of the count exceeds it.
+ */
+#ifdef GFIFO_CFG_STATS
+#define __GFIFO_STATS_PROD(mode, align)                                        \
+  align __GFIFO_IDX_##mode(uint64_t) st_pushes;                                \
+  __GFIFO_IDX_##mode(uint64_t) st_push_fail, st_bytes_in, st_lost, st_hwm;
+#define __GFIFO_STATS_CONS(mode, align)                                        \
+  align __GFIFO_IDX_##mode(uint64_t) st_pops;                                  \
+  __GFIFO_IDX_##mode(uint64_t) st_pop_empty, st_bytes_out;
+#define __GFIFO_STAT_ADD(mode, f, field, n)                                    \
+  __GFIFO_ST_##mode(&(f)->field,                                               \
+                    __GFIFO_LD_##mode(&(f)->field, relaxed) + (uint64_t)(n),   \
+                    relaxed)
+#define __GFIFO_STAT_PUSHED(mode, idx_t, f, n, bytes, in, out)                 \
+  do {                                                                         \
+    __GFIFO_STAT_ADD(mode, f, st_pushes, n);                                   \
+    __GFIFO_STAT_ADD(mode, f, st_bytes_in, bytes);                             \
+    if ((idx_t)((in) + (n) - (out)) >                                          \
+        __GFIFO_LD_##mode(&(f)->st_hwm, relaxed)) {                            \
+      idx_t __c = (idx_t)((in) + (n) - __GFIFO_LD_##mode(&(f)->o, relaxed));   \
+      if (__c > __GFIFO_LD_##mode(&(f)->st_hwm, relaxed)) {                    \
+        __GFIFO_ST_##mode(&(f)->st_hwm, __c, relaxed);                         \
+      }                                                                        \
+    }                                                                          \
+  } while (0)
+#define __GFIFO_STAT_POPPED(mode, f, n, bytes)                                 \
+  do {                                                                         \
+    __GFIFO_STAT_ADD(mode, f, st_pops, n);                                     \
+    __GFIFO_STAT_ADD(mode, f, st_bytes_out, bytes);                            \
+  } while (0)
+#define __GFIFO_STATS_RESET(mode, f)                                           \
+  do {                                                                         \
+    __GFIFO_ST_##mode(&(f)->st_pushes, 0, relaxed);                            \
+    __GFIFO_ST_##mode(&(f)->st_push_fail, 0, relaxed);                         \
+    __GFIFO_ST_##mode(&(f)->st_bytes_in, 0, relaxed);                          \
+    __GFIFO_ST_##mode(&(f)->st_lost, 0, relaxed);                              \
+    __GFIFO_ST_##mode(&(f)->st_hwm, 0, relaxed);                               \
+    __GFIFO_ST_##mode(&(f)->st_pops, 0, relaxed);                              \
+    __GFIFO_ST_##mode(&(f)->st_pop_empty, 0, relaxed);                         \
+    __GFIFO_ST_##mode(&(f)->st_bytes_out, 0, relaxed);                         \
+  } while (0)
+#define __GFIFO_STATS_READ(mode, f, s)                                         \
+  ((s)->pushes = __GFIFO_LD_##mode(&(f)->st_pushes, relaxed),                  \
+   (s)->push_fail = __GFIFO_LD_##mode(&(f)->st_push_fail, relaxed),            \
+   (s)->bytes_in = __GFIFO_LD_##mode(&(f)->st_bytes_in, relaxed),              \
+   (s)->lost = __GFIFO_LD_##mode(&(f)->st_lost, relaxed),                      \
+   (s)->hwm = __GFIFO_LD_##mode(&(f)->st_hwm, relaxed),                        \
+   (s)->pops = __GFIFO_LD_##mode(&(f)->st_pops, relaxed),                      \
+   (s)->pop_empty = __GFIFO_LD_##mode(&(f)->st_pop_empty, relaxed),            \
+   (s)->bytes_out = __GFIFO_LD_##mode(&(f)->st_bytes_out, relaxed), true)
+#else
+#define __GFIFO_STATS_PROD(mode, align)
+#define __GFIFO_STATS_CONS(mode, align)
+#define __GFIFO_STAT_ADD(mode, f, field, n) ((void)0)
+#define __GFIFO_STAT_PUSHED(mode, idx_t, f, n, bytes, in, out) ((void)0)
+#define __GFIFO_STAT_POPPED(mode, f, n, bytes) ((void)0)
+#define __GFIFO_STATS_RESET(mode, f) ((void)0)
+#define __GFIFO_STATS_READ(mode, f, s) (memset((s), 0, sizeof(*(s))), false)
+#endif
+
+/**
+ * @brief Snapshot of the optional queueing delay histogram of a FIFO.
+ *
+ * Filled by gfifo_<name>_latency() when GFIFO_CFG_LATENCY is defined before
+ * including this header. Delays are in GFIFO_LAT_NOW() ticks; every
+ * percentile is the upper bound of its histogram bucket, i.e. at most
+ * 2^-GFIFO_LAT_SUB_BITS above the exact value.
+ */
+typedef struct {
+  uint64_t samples; /**< Stamped batches that were popped. */
+  uint64_t p50;     /**< Median delay. */
+  uint64_t p90;     /**< 90th percentile delay. */
+  uint64_t p99;     /**< 99th percentile delay. */
+  uint64_t p999;    /**< 99.9th percentile delay. */
+  uint64_t max;     /**< Largest delay. */
+} gfifo_latency_t;
+
+/*
+ * Optional queueing delay histogram (GFIFO_CFG_LATENCY), compiled out by
+ * default.
+ *
+ * Every successful push, push_array, push_some, push_batch and push_commit
+ * takes one GFIFO_LAT_NOW() timestamp for its batch and records it with
+ * the position of the batch's first element in a small stamp ring
+ * (GFIFO_LAT_STAMPS entries) before publishing i. When the stamp ring is
+ * full the batch is not stamped, so at most GFIFO_LAT_STAMPS batches are
+ * sampled at a time and a backlog costs no extra work.
+ *
+ * Once a pop, drop, pop_array, pop_some, pop_batch or release moves o past
+ * a stamped position, the consumer adds now - stamp to a log-linear
+ * histogram: values below 2^GFIFO_LAT_SUB_BITS have one bucket each, every
+ * higher power of two is split into 2^GFIFO_LAT_SUB_BITS buckets. The
+ * stamp ring belongs to the producer and the histogram to the consumer, so
+ * neither adds writes to the other side's lines. Overwrites of the lossy
+ * variant are not stamped.
+ */
+#ifdef GFIFO_CFG_LATENCY
+
+/** Stamp ring entries, a power of two. */
+#ifndef GFIFO_LAT_STAMPS
+#define GFIFO_LAT_STAMPS 16
+#endif
+
+/** Sub-buckets per power of two are 2^GFIFO_LAT_SUB_BITS. */
+#ifndef GFIFO_LAT_SUB_BITS
+#define GFIFO_LAT_SUB_BITS 3
+#endif
+
+/**
+ * @brief Timestamp source in ticks, monotonic and cheap.
+ *
+ * Defaults to the TSC on x86, the virtual counter on ARM64 and
+ * CLOCK_MONOTONIC_COARSE nanoseconds elsewhere on Linux, which under
+ * -std=c11 needs _POSIX_C_SOURCE >= 199309L (or _GNU_SOURCE) defined before
+ * the first #include. Override before including this header on other
+ * targets (e.g. DWT->CYCCNT on Cortex-M).
+ */
+#ifndef GFIFO_LAT_NOW
+#if defined(__x86_64__) || defined(__i386__)
+#define GFIFO_LAT_NOW() ((uint64_t)__builtin_ia32_rdtsc())
+#elif defined(__aarch64__)
+static inline uint64_t __gfifo_lat_now(void) {
+  uint64_t t;
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(t));
+  return t;
+}
+#define GFIFO_LAT_NOW() __gfifo_lat_now()
+#elif defined(__linux__)
+#include <time.h>
+static inline uint64_t __gfifo_lat_now(void) {
+  struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#define GFIFO_LAT_NOW() __gfifo_lat_now()
+#else
+#error "GFIFO_CFG_LATENCY: define GFIFO_LAT_NOW() for this target"
+#endif
+#endif
+
+#define __GFIFO_LAT_ENABLED true
+#define __GFIFO_LAT_SUB ((uint64_t)1 << GFIFO_LAT_SUB_BITS)
+#define __GFIFO_LAT_BUCKETS ((64 - GFIFO_LAT_SUB_BITS + 1) * __GFIFO_LAT_SUB)
+
+/* Histogram bucket of delay v. */
+static inline uint32_t __gfifo_lat_bucket(uint64_t v) {
+  if (v < __GFIFO_LAT_SUB) {
+    return (uint32_t)v;
+  }
+  uint32_t e = 63;
+  while ((v >> e) == 0) {
+    e--;
+  }
+  uint32_t sh = e - GFIFO_LAT_SUB_BITS;
+  return (uint32_t)(((uint64_t)(sh + 1) << GFIFO_LAT_SUB_BITS) |
+                    ((v >> sh) & (__GFIFO_LAT_SUB - 1)));
+}
+
+/* Largest delay that falls into bucket b. */
+static inline uint64_t __gfifo_lat_upper(uint32_t b) {
+  if (b < __GFIFO_LAT_SUB) {
+    return b;
+  }
+  uint32_t sh = (b >> GFIFO_LAT_SUB_BITS) - 1;
+  uint64_t m = (b & (__GFIFO_LAT_SUB - 1)) | __GFIFO_LAT_SUB;
+  return (m << sh) + (((uint64_t)1 << sh) - 1);
+}
+
+/* Fill snapshot s from the histogram of f. */
+#define __GFIFO_LAT_READ(mode, f, s)                                           \
+  do {                                                                         \
+    uint64_t __tot = 0, __acc = 0;                                             \
+    memset((s), 0, sizeof(*(s)));                                              \
+    for (uint32_t __b = 0; __b < __GFIFO_LAT_BUCKETS; __b++) {                 \
+      __tot += __GFIFO_LD_##mode(&(f)->lt_hist[__b], relaxed);                 \
+    }                                                                          \
+    (s)->samples = __tot;                                                      \
+    for (uint32_t __b = 0; __b < __GFIFO_LAT_BUCKETS && __tot; __b++) {        \
+      uint64_t __c = __GFIFO_LD_##mode(&(f)->lt_hist[__b], relaxed);           \
+      if (__c == 0) {                                                          \
+        continue;                                                              \
+      }                                                                        \
+      __acc += __c;                                                            \
+      uint64_t __v = __gfifo_lat_upper(__b);                                   \
+      if ((__acc - __c) * 2 < __tot && __acc * 2 >= __tot) {                   \
+        (s)->p50 = __v;                                                        \
+      }                                                                        \
+      if ((__acc - __c) * 10 < __tot * 9 && __acc * 10 >= __tot * 9) {         \
+        (s)->p90 = __v;                                                        \
+      }                                                                        \
+      if ((__acc - __c) * 100 < __tot * 99 && __acc * 100 >= __tot * 99) {     \
+        (s)->p99 = __v;                                                        \
+      }                                                                        \
+      if ((__acc - __c) * 1000 < __tot * 999 && __acc * 1000 >= __tot * 999) { \
+        (s)->p999 = __v;                                                       \
+      }                                                                        \
+      (s)->max = __v;                                                          \
+    }                                                                          \
+  } while (0)
+
+#define __GFIFO_LAT_PROD(mode, idx_t, align)                                   \
+  align __GFIFO_IDX_##mode(uint32_t) lt_si;                                    \
+  uint32_t lt_soc;                                                             \
+  idx_t lt_pos[GFIFO_LAT_STAMPS];                                              \
+  uint64_t lt_t[GFIFO_LAT_STAMPS];
+#define __GFIFO_LAT_CONS(mode, idx_t, align)                                   \
+  align __GFIFO_IDX_##mode(uint32_t) lt_so;                                    \
+  uint32_t lt_sic;                                                             \
+  __GFIFO_IDX_##mode(uint64_t) lt_hist[__GFIFO_LAT_BUCKETS];
+#define __GFIFO_LAT_STAMP(mode, f, in, n)                                      \
+  do {                                                                         \
+    uint32_t __s = __GFIFO_LD_##mode(&(f)->lt_si, relaxed);                    \
+    if ((n) > 0 &&                                                             \
+        (__s - (f)->lt_soc < GFIFO_LAT_STAMPS ||                               \
+         __s - ((f)->lt_soc = __GFIFO_LD_##mode(&(f)->lt_so, acquire)) <       \
+             GFIFO_LAT_STAMPS)) {                                              \
+      (f)->lt_pos[__s & (GFIFO_LAT_STAMPS - 1)] = (in);                        \
+      (f)->lt_t[__s & (GFIFO_LAT_STAMPS - 1)] = GFIFO_LAT_NOW();               \
+      __GFIFO_ST_##mode(&(f)->lt_si, __s + 1, release);                        \
+    }                                                                          \
+  } while (0)
+#define __GFIFO_LAT_POPPED(mode, idx_t, f, end)                                \
+  do {                                                                         \
+    uint32_t __s = __GFIFO_LD_##mode(&(f)->lt_so, relaxed);                    \
+    if (__s == (f)->lt_sic &&                                                  \
+        __s == ((f)->lt_sic = __GFIFO_LD_##mode(&(f)->lt_si, acquire))) {      \
+      break;                                                                   \
+    }                                                                          \
+    uint32_t __s0 = __s;                                                       \
+    uint64_t __now = 0;                                                        \
+    for (; __s != (f)->lt_sic; __s++) {                                        \
+      uint32_t __k = __s & (GFIFO_LAT_STAMPS - 1);                             \
+      idx_t __pos = (f)->lt_pos[__k];                                          \
+      if ((idx_t)((idx_t)(end) - 1 - __pos) >= (f)->cap) {                     \
+        /* at or after end: not popped yet; before the last cap elements:      \
+         * overwritten by push_overwrite(), drop the stamp */                  \
+        if ((idx_t)(__pos - (idx_t)(end)) <= (idx_t)(~(idx_t)0 >> 1)) {        \
+          break;                                                               \
+        }                                                                      \
+        continue;                                                              \
+      }                                                                        \
+      if (__now == 0) {                                                        \
+        __now = GFIFO_LAT_NOW();                                               \
+      }                                                                        \
+      uint32_t __b = __gfifo_lat_bucket(__now - (f)->lt_t[__k]);               \
+      __GFIFO_ST_##mode(&(f)->lt_hist[__b],                                    \
+                        __GFIFO_LD_##mode(&(f)->lt_hist[__b], relaxed) + 1,    \
+                        relaxed);                                              \
+    }                                                                          \
+    if (__s != __s0) {                                                         \
+      __GFIFO_ST_##mode(&(f)->lt_so, __s, release);                            \
+    }                                                                          \
+  } while (0)
+#define __GFIFO_LAT_RESET(mode, f)                                             \
+  do {                                                                         \
+    __GFIFO_ST_##mode(&(f)->lt_si, 0, relaxed);                                \
+    __GFIFO_ST_##mode(&(f)->lt_so, 0, relaxed);                                \
+    (f)->lt_soc = (f)->lt_sic = 0;                                             \
+    for (uint32_t __b = 0; __b < __GFIFO_LAT_BUCKETS; __b++) {                 \
+      __GFIFO_ST_##mode(&(f)->lt_hist[__b], 0, relaxed);                       \
+    }                                                                          \
+  } while (0)
+#define __GFIFO_LAT_DROP(mode, f)                                              \
+  do {                                                                         \
+    uint32_t __s = __GFIFO_LD_##mode(&(f)->lt_si, relaxed);                    \
+    __GFIFO_ST_##mode(&(f)->lt_so, __s, relaxed);                              \
+    (f)->lt_soc = (f)->lt_sic = __s;                                           \
+  } while (0)
+#else
+#define __GFIFO_LAT_ENABLED false
+#define __GFIFO_LAT_PROD(mode, idx_t, align)
+#define __GFIFO_LAT_CONS(mode, idx_t, align)
+#define __GFIFO_LAT_STAMP(mode, f, in, n) ((void)0)
+#define __GFIFO_LAT_POPPED(mode, idx_t, f, end) ((void)0)
+#define __GFIFO_LAT_RESET(mode, f) ((void)0)
+#define __GFIFO_LAT_DROP(mode, f) ((void)0)
+#define __GFIFO_LAT_READ(mode, f, s) memset((s), 0, sizeof(*(s)))
+#endif
+
+/*
+ * Struct layout and opposite-index caching for each layout.
+ *
+ * PACKED : all fields share one cache line, the opposite index is always
+ *          loaded from the shared field.
+ * CL     : read-only fields, producer state and consumer state live on
+ *          separate cache lines. Each side keeps a private copy of the
+ *          opposite index (oc on the producer side, ic on the consumer
+ *          side) and only reloads the shared one when its copy says there
+ *          is not enough space or data for the request.
+ *
+ * __GFIFO_PROD_OUT_<layout>() yields the `o` seen by the producer and
+ * __GFIFO_CONS_IN_<layout>() yields the `i` seen by the consumer, given the
+ * number of elements the caller needs. __GFIFO_L2E_<layout>() yields how
+ * many elements starting at buf[ofst] are contiguous in memory; bulk copies
+ * and spans are split in two where it is exceeded. __GFIFO_SET_BUF_<layout>()
+ * attaches the storage passed to init().
+ */
+#define __GFIFO_STRUCT_PACKED(name, type, idx_t, mode)                         \
+  typedef struct {                                                             \
+    type *buf;                                                                 \
+    idx_t cap;                                                                 \
+    idx_t msk;                                                                 \
+    __GFIFO_IDX_##mode(idx_t) i;                                               \
+    __GFIFO_IDX_##mode(idx_t) o;                                               \
+    __GFIFO_STATS_PROD(mode, __GFIFO_ALIGNED(GFIFO_CACHELINE))                 \
+    __GFIFO_STATS_CONS(mode, __GFIFO_ALIGNED(GFIFO_CACHELINE))                 \
+    __GFIFO_LAT_PROD(mode, idx_t, __GFIFO_ALIGNED(GFIFO_CACHELINE))            \
+    __GFIFO_LAT_CONS(mode, idx_t, __GFIFO_ALIGNED(GFIFO_CACHELINE))            \
+  } gfifo_##name##_t
+
+#define __GFIFO_SET_BUF_PACKED(f, b) ((f)->buf = (b))
+#define __GFIFO_CACHE_RESET_PACKED(f) ((void)0)
+#define __GFIFO_L2E_PACKED(idx_t, f, ofst) ((f)->cap - (ofst))
+#define __GFIFO_PROD_OUT_PACKED(mode, idx_t, f, in, need)                      \
+  __GFIFO_LD_##mode(&(f)->o, acquire)
+#define __GFIFO_CONS_IN_PACKED(mode, idx_t, f, out, need)                      \
+  __GFIFO_LD_##mode(&(f)->i, acquire)
+
+#define __GFIFO_STRUCT_CL(name, type, idx_t, mode)                             \
+  typedef struct {                                                             \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) type *buf;                                \
+    idx_t cap;                                                                 \
+    idx_t msk;                                                                 \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) __GFIFO_IDX_##mode(idx_t) i;              \
+    idx_t oc;                                                                  \
+    __GFIFO_STATS_PROD(mode, )                                                 \
+    __GFIFO_LAT_PROD(mode, idx_t, )                                            \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) __GFIFO_IDX_##mode(idx_t) o;              \
+    idx_t ic;                                                                  \
+    __GFIFO_STATS_CONS(mode, )                                                 \
+    __GFIFO_LAT_CONS(mode, idx_t, )                                            \
+  } gfifo_##name##_t
+
+#define __GFIFO_SET_BUF_CL(f, b) ((f)->buf = (b))
+#define __GFIFO_CACHE_RESET_CL(f) ((f)->oc = (f)->ic = 0)
+#define __GFIFO_L2E_CL(idx_t, f, ofst) ((f)->cap - (ofst))
+#define __GFIFO_PROD_OUT_CL(mode, idx_t, f, in, need)                          \
+  (((idx_t)((f)->cap - (idx_t)((in) - (f)->oc)) >= (need))                     \
+       ? (f)->oc                                                               \
+       : ((f)->oc = __GFIFO_LD_##mode(&(f)->o, acquire)))
+#define __GFIFO_CONS_IN_CL(mode, idx_t, f, out, need)                          \
+  (((idx_t)((f)->ic - (out)) >= (need))                                        \
+       ? (f)->ic                                                               \
+       : ((f)->ic = __GFIFO_LD_##mode(&(f)->i, acquire)))
+
 /**
  * @brief  Declare a generic ring FIFO type and its associated operations.
  *
@@ -42,16 +578,211 @@
  *     gfifo_<name>_t
  *
  * All operations are O(1) and safe for single‑producer / single‑consumer
- * (SPSC) usage. Multi‑threaded usage requires external synchronization.
+ * (SPSC) usage on a single core (e.g. ISR-to-task). Cross-core usage should
+ * use DECLARE_GFIFO_TYPE_ATOMIC(); any other multi‑threaded usage requires
+ * external synchronization.
  */
 #define DECLARE_GFIFO_TYPE(name, type)                                         \
-  typedef struct {                                                             \
-    type *buf;                                                                 \
-    uint32_t cap;                                                              \
-    uint32_t msk;                                                              \
-    volatile uint32_t i;                                                       \
-    volatile uint32_t o;                                                       \
-  } gfifo_##name##_t;                                                          \
+  __GFIFO_DECLARE(name, type, uint32_t, PLAIN, PACKED)
+
+/**
+ * @brief  Declare a generic ring FIFO type with cache-line separated state.
+ *
+ * Same type name and API as DECLARE_GFIFO_TYPE(). The read-only fields, the
+ * producer index and the consumer index are placed on separate
+ * GFIFO_CACHELINE aligned lines, so a push does not invalidate the
+ * consumer's line and a pop does not invalidate the producer's line. Each
+ * side caches the opposite index and only re-reads the shared one when the
+ * ring looks full (producer) or empty (consumer).
+ *
+ * Instances must be GFIFO_CACHELINE aligned (static storage or
+ * aligned_alloc()).
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ */
+#define DECLARE_GFIFO_TYPE_CL(name, type)                                      \
+  __GFIFO_DECLARE(name, type, uint32_t, PLAIN, CL)
+
+/**
+ * @brief  Declare a generic ring FIFO type with a custom index type.
+ *
+ * Same as DECLARE_GFIFO_TYPE(), but cap/msk/i/o and every count, length
+ * and offset of the generated API use idx_t instead of uint32_t:
+ *   - uint64_t removes the 2^31 capacity ceiling and gives positions that
+ *     do not wrap in practice, usable as replay/checkpoint offsets;
+ *   - uint8_t/uint16_t save RAM on small MCUs.
+ *
+ * The capacity is limited to the largest power of two idx_t can hold
+ * (2^(bits - 1)), so i - o can always represent a full FIFO.
+ *
+ * @param name   Suffix used to form the FIFO type name.
+ * @param type   Element type stored in the FIFO.
+ * @param idx_t  Unsigned integer type used for indices.
+ */
+#define DECLARE_GFIFO_TYPE_EX(name, type, idx_t)                               \
+  __GFIFO_DECLARE(name, type, idx_t, PLAIN, PACKED)
+
+/**
+ * @brief  DECLARE_GFIFO_TYPE_CL() with a custom index type.
+ *
+ * See DECLARE_GFIFO_TYPE_EX() for the meaning of idx_t.
+ */
+#define DECLARE_GFIFO_TYPE_CL_EX(name, type, idx_t)                            \
+  __GFIFO_DECLARE(name, type, idx_t, PLAIN, CL)
+
+#ifdef GFIFO_HAS_ATOMICS
+/**
+ * @brief  Declare a generic ring FIFO type with C11 atomic indices.
+ *
+ * Generates exactly the same type name and API as DECLARE_GFIFO_TYPE(), but
+ * i/o are _Atomic and every operation publishes them with explicit memory
+ * ordering:
+ *   - the producer stores i with release after writing buf, and loads o
+ *     with acquire before reusing a slot;
+ *   - the consumer stores o with release after reading buf, and loads i
+ *     with acquire before reading a slot.
+ *
+ * This makes the FIFO safe for SPSC usage across cores on weakly ordered
+ * CPUs (e.g. ARM64) without external locking. Only available when the
+ * compiler provides <stdatomic.h>.
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ */
+#define DECLARE_GFIFO_TYPE_ATOMIC(name, type)                                  \
+  __GFIFO_DECLARE(name, type, uint32_t, ATOMIC, PACKED)
+
+/**
+ * @brief  Declare an atomic FIFO type with cache-line separated state.
+ *
+ * Combines the ordering of DECLARE_GFIFO_TYPE_ATOMIC() with the layout of
+ * DECLARE_GFIFO_TYPE_CL(). This is the recommended variant for cross-core
+ * SPSC pipelines.
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ */
+#define DECLARE_GFIFO_TYPE_ATOMIC_CL(name, type)                               \
+  __GFIFO_DECLARE(name, type, uint32_t, ATOMIC, CL)
+
+/**
+ * @brief  DECLARE_GFIFO_TYPE_ATOMIC() with a custom index type.
+ *
+ * See DECLARE_GFIFO_TYPE_EX() for the meaning of idx_t. _Atomic idx_t
+ * should be lock-free on the target (e.g. 64-bit indices on a 32-bit core
+ * may fall back to a lock inside libatomic).
+ */
+#define DECLARE_GFIFO_TYPE_ATOMIC_EX(name, type, idx_t)                        \
+  __GFIFO_DECLARE(name, type, idx_t, ATOMIC, PACKED)
+
+/**
+ * @brief  DECLARE_GFIFO_TYPE_ATOMIC_CL() with a custom index type.
+ *
+ * See DECLARE_GFIFO_TYPE_ATOMIC_EX().
+ */
+#define DECLARE_GFIFO_TYPE_ATOMIC_CL_EX(name, type, idx_t)                     \
+  __GFIFO_DECLARE(name, type, idx_t, ATOMIC, CL)
+
+/**
+ * @brief  Declare an overwrite-oldest ("lossy") atomic FIFO type.
+ *
+ * Same API and ordering as DECLARE_GFIFO_TYPE_ATOMIC(), plus
+ * push_overwrite() and push_array_overwrite(), which never fail: when the
+ * ring is full they advance o past the oldest elements with a CAS and
+ * report how many were lost. The consumer commits o with a CAS as well, so
+ * pop/drop/pop_array/pop_some retry their copy when the producer overwrote
+ * the elements in the meantime and never return torn data.
+ *
+ * peek/peek_at/readable_spans/pop_batch hand out elements in place, which
+ * the producer may overwrite while they are being read; release() and
+ * pop_batch() then fail (false / 0) and the data must be discarded.
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ */
+#define DECLARE_GFIFO_TYPE_LOSSY(name, type)                                   \
+  __GFIFO_DECLARE(name, type, uint32_t, LOSSY, PACKED);                        \
+  __GFIFO_LOSSY_DECLARE(name, type)
+#endif
+
+#ifdef GFIFO_HAS_ISR
+/**
+ * @brief  Declare a FIFO type for ISR producer / thread consumer usage.
+ *
+ * Same API and layout as DECLARE_GFIFO_TYPE(), but i/o are not volatile.
+ * Each operation reads the indices into locals once and orders them
+ * against the buffer accesses with GFIFO_ISR_BARRIER():
+ *   - the producer issues the barrier after writing buf and before
+ *     publishing i;
+ *   - the consumer issues it after loading i and before reading buf, and
+ *     again before publishing o.
+ * In between, the compiler keeps values in registers instead of reloading
+ * them on every access.
+ *
+ * When GFIFO_ENTER_CRITICAL() and GFIFO_EXIT_CRITICAL() are defined before
+ * including this header, push/push_array/push_some/pop/pop_array/pop_some
+ * also get *_critical variants wrapped in these hooks. Use them on the
+ * side that has more than one producer (or consumer), e.g. two ISRs of
+ * different priority feeding the same FIFO.
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ */
+#define DECLARE_GFIFO_TYPE_ISR(name, type)                                     \
+  __GFIFO_DECLARE(name, type, uint32_t, ISR, PACKED);                          \
+  __GFIFO_ISR_DECLARE(name, type, uint32_t)
+
+/**
+ * @brief  DECLARE_GFIFO_TYPE_ISR() with a custom index type.
+ *
+ * See DECLARE_GFIFO_TYPE_EX(). idx_t must be loaded and stored with single
+ * instructions on the target (e.g. no 64-bit indices on 32-bit MCUs).
+ */
+#define DECLARE_GFIFO_TYPE_ISR_EX(name, type, idx_t)                           \
+  __GFIFO_DECLARE(name, type, idx_t, ISR, PACKED);                             \
+  __GFIFO_ISR_DECLARE(name, type, idx_t)
+
+#if defined(GFIFO_ENTER_CRITICAL) && defined(GFIFO_EXIT_CRITICAL)
+#define __GFIFO_ISR_CRITICAL(name, ret, op, params, args)                      \
+  /** @brief op() inside GFIFO_ENTER_CRITICAL()/GFIFO_EXIT_CRITICAL(). */      \
+  static inline ret gfifo_##name##_##op##_critical params {                    \
+    GFIFO_ENTER_CRITICAL();                                                    \
+    ret r = gfifo_##name##_##op args;                                          \
+    GFIFO_EXIT_CRITICAL();                                                     \
+    return r;                                                                  \
+  }
+#define __GFIFO_ISR_DECLARE(name, type, idx_t)                                 \
+  __GFIFO_ISR_CRITICAL(name, bool, push,                                       \
+                       (gfifo_##name##_t * f, const type *e), (f, e))          \
+  __GFIFO_ISR_CRITICAL(name, bool, push_array,                                 \
+                       (gfifo_##name##_t * f, const type *arr, idx_t len),     \
+                       (f, arr, len))                                          \
+  __GFIFO_ISR_CRITICAL(name, idx_t, push_some,                                 \
+                       (gfifo_##name##_t * f, const type *arr, idx_t len),     \
+                       (f, arr, len))                                          \
+  __GFIFO_ISR_CRITICAL(name, bool, pop, (gfifo_##name##_t * f, type *e),       \
+                       (f, e))                                                 \
+  __GFIFO_ISR_CRITICAL(name, bool, pop_array,                                  \
+                       (gfifo_##name##_t * f, type *arr, idx_t len),           \
+                       (f, arr, len))                                          \
+  __GFIFO_ISR_CRITICAL(name, idx_t, pop_some,                                  \
+                       (gfifo_##name##_t * f, type *arr, idx_t len),           \
+                       (f, arr, len))
+#else
+#define __GFIFO_ISR_DECLARE(name, type, idx_t)
+#endif
+#endif
+
+/*
+ * Common implementation behind the public DECLARE_GFIFO_TYPE* macros.
+ * `idx_t` is the unsigned index type, `mode` selects the index access
+ * primitives (see __GFIFO_LD_<mode>) and `layout` the struct layout (see
+ * __GFIFO_STRUCT_<layout>). Differences of idx_t values are cast back to
+ * idx_t before being compared, since narrow types promote to int.
+ */
+#define __GFIFO_DECLARE(name, type, idx_t, mode, layout)                       \
+  __GFIFO_STRUCT_##layout(name, type, idx_t, mode);                            \
                                                                                \
   /**                                                                          \
    * @brief Initialize FIFO with user_provided buffer.                         \
@@ -62,12 +793,16 @@
    * @return false Invalid size or NULL buffer.                                \
    */                                                                          \
   static inline bool gfifo_##name##_init(gfifo_##name##_t *f, type *buf,       \
-                                         uint32_t size) {                      \
+                                         idx_t size) {                         \
     if (size == 0 || (size & (size - 1)) != 0 || buf == NULL) {                \
       return false;                                                            \
     }                                                                          \
-    f->i = f->o = 0;                                                           \
-    f->buf = buf;                                                              \
+    __GFIFO_ST_##mode(&f->i, 0, relaxed);                                      \
+    __GFIFO_ST_##mode(&f->o, 0, relaxed);                                      \
+    __GFIFO_CACHE_RESET_##layout(f);                                           \
+    __GFIFO_STATS_RESET(mode, f);                                              \
+    __GFIFO_LAT_RESET(mode, f);                                                \
+    __GFIFO_SET_BUF_##layout(f, buf);                                          \
     f->cap = size;                                                             \
     f->msk = size - 1;                                                         \
     return true;                                                               \
@@ -79,7 +814,10 @@
    * @param f FIFO instance.                                                   \
    */                                                                          \
   static inline void gfifo_##name##_reset(gfifo_##name##_t *f) {               \
-    f->i = f->o = 0;                                                           \
+    __GFIFO_ST_##mode(&f->i, 0, relaxed);                                      \
+    __GFIFO_ST_##mode(&f->o, 0, relaxed);                                      \
+    __GFIFO_CACHE_RESET_##layout(f);                                           \
+    __GFIFO_LAT_DROP(mode, f);                                                 \
   }                                                                            \
                                                                                \
   /**                                                                          \
@@ -90,7 +828,8 @@
    * @return false FIFO has at least one element.                              \
    */                                                                          \
   static inline bool gfifo_##name##_is_empty(const gfifo_##name##_t *f) {      \
-    return f->i == f->o;                                                       \
+    return __GFIFO_LD_##mode(&f->i, acquire) ==                                \
+           __GFIFO_LD_##mode(&f->o, acquire);                                  \
   }                                                                            \
                                                                                \
   /**                                                                          \
@@ -101,7 +840,8 @@
    * @return false FIFO has free space.                                        \
    */                                                                          \
   static inline bool gfifo_##name##_is_full(const gfifo_##name##_t *f) {       \
-    return (f->i - f->o) == f->cap;                                            \
+    return (idx_t)(__GFIFO_LD_##mode(&f->i, acquire) -                         \
+                   __GFIFO_LD_##mode(&f->o, acquire)) == f->cap;               \
   }                                                                            \
                                                                                \
   /**                                                                          \
@@ -110,8 +850,9 @@
    * @param f FIFO instance.                                                   \
    * @return Number of elements currently in FIFO.                             \
    */                                                                          \
-  static inline uint32_t gfifo_##name##_count(const gfifo_##name##_t *f) {     \
-    return (f->i - f->o);                                                      \
+  static inline idx_t gfifo_##name##_count(const gfifo_##name##_t *f) {        \
+    return (idx_t)(__GFIFO_LD_##mode(&f->i, acquire) -                         \
+                   __GFIFO_LD_##mode(&f->o, acquire));                         \
   }                                                                            \
                                                                                \
   /**                                                                          \
@@ -124,13 +865,16 @@
    * @return false FIFO is full.                                               \
    */                                                                          \
   static inline bool gfifo_##name##_push(gfifo_##name##_t *f, const type *e) { \
-    uint32_t cnt = f->i - f->o;                                                \
+    idx_t in = __GFIFO_LD_##mode(&f->i, relaxed);                              \
+    idx_t cnt = in - __GFIFO_PROD_OUT_##layout(mode, idx_t, f, in, 1);         \
     if (cnt < f->cap) {                                                        \
-      uint32_t idx = f->i;                                                     \
-      f->buf[idx & f->msk] = *e;                                               \
-      f->i++;                                                                  \
+      f->buf[in & f->msk] = *e;                                                \
+      __GFIFO_LAT_STAMP(mode, f, in, 1);                                       \
+      __GFIFO_ST_##mode(&f->i, in + 1, release);                               \
+      __GFIFO_STAT_PUSHED(mode, idx_t, f, 1, sizeof(type), in, in - cnt);      \
       return true;                                                             \
     }                                                                          \
+    __GFIFO_STAT_ADD(mode, f, st_push_fail, 1);                                \
     return false;                                                              \
   }                                                                            \
                                                                                \
@@ -144,14 +888,18 @@
    * @return false FIFO is empty.                                              \
    */                                                                          \
   static inline bool gfifo_##name##_pop(gfifo_##name##_t *f, type *e) {        \
-    uint32_t cnt = f->i - f->o;                                                \
-    if (cnt > 0) {                                                             \
-      uint32_t idx = f->o;                                                     \
-      *e = f->buf[idx & f->msk];                                               \
-      f->o++;                                                                  \
-      return true;                                                             \
-    }                                                                          \
-    return false;                                                              \
+    idx_t out;                                                                 \
+    do {                                                                       \
+      out = __GFIFO_LD_##mode(&f->o, relaxed);                                 \
+      if (__GFIFO_CONS_IN_##layout(mode, idx_t, f, out, 1) == out) {           \
+        __GFIFO_STAT_ADD(mode, f, st_pop_empty, 1);                            \
+        return false;                                                          \
+      }                                                                        \
+      *e = f->buf[out & f->msk];                                               \
+    } while (!__GFIFO_CONS_ST_##mode(&f->o, out, out + 1));                    \
+    __GFIFO_STAT_POPPED(mode, f, 1, sizeof(type));                             \
+    __GFIFO_LAT_POPPED(mode, idx_t, f, out + 1);                               \
+    return true;                                                               \
   }                                                                            \
                                                                                \
   /**                                                                          \
@@ -163,12 +911,17 @@
    * @return false FIFO is empty.                                              \
    */                                                                          \
   static inline bool gfifo_##name##_drop(gfifo_##name##_t *f) {                \
-    uint32_t cnt = f->i - f->o;                                                \
-    if (cnt > 0) {                                                             \
-      f->o++;                                                                  \
-      return true;                                                             \
-    }                                                                          \
-    return false;                                                              \
+    idx_t out;                                                                 \
+    do {                                                                       \
+      out = __GFIFO_LD_##mode(&f->o, relaxed);                                 \
+      if (__GFIFO_CONS_IN_##layout(mode, idx_t, f, out, 1) == out) {           \
+        __GFIFO_STAT_ADD(mode, f, st_pop_empty, 1);                            \
+        return false;                                                          \
+      }                                                                        \
+    } while (!__GFIFO_CONS_ST_##mode(&f->o, out, out + 1));                    \
+    __GFIFO_STAT_POPPED(mode, f, 1, sizeof(type));                             \
+    __GFIFO_LAT_POPPED(mode, idx_t, f, out + 1);                               \
+    return true;                                                               \
   }                                                                            \
                                                                                \
   /**                                                                          \
@@ -181,11 +934,10 @@
    * @return false FIFO is empty.                                              \
    */                                                                          \
   static inline bool gfifo_##name##_peek(const gfifo_##name##_t *f, type *e) { \
-    uint32_t cnt = f->i - f->o;                                                \
-    uint32_t idx;                                                              \
+    idx_t out = __GFIFO_LD_##mode(&f->o, relaxed);                             \
+    idx_t cnt = __GFIFO_LD_##mode(&f->i, acquire) - out;                       \
     if (cnt > 0) {                                                             \
-      idx = f->o;                                                              \
-      *e = f->buf[idx & f->msk];                                               \
+      *e = f->buf[out & f->msk];                                               \
       return true;                                                             \
     }                                                                          \
     return false;                                                              \
@@ -202,12 +954,11 @@
    * @return false Offset out of range.                                        \
    */                                                                          \
   static inline bool gfifo_##name##_peek_at(const gfifo_##name##_t *f,         \
-                                            type *e, uint32_t ofst) {          \
-    uint32_t cnt = f->i - f->o;                                                \
-    uint32_t idx;                                                              \
+                                            type *e, idx_t ofst) {             \
+    idx_t out = __GFIFO_LD_##mode(&f->o, relaxed);                             \
+    idx_t cnt = __GFIFO_LD_##mode(&f->i, acquire) - out;                       \
     if (ofst < cnt) {                                                          \
-      idx = f->o;                                                              \
-      *e = f->buf[(idx + ofst) & f->msk];                                      \
+      *e = f->buf[(out + ofst) & f->msk];                                      \
       return true;                                                             \
     }                                                                          \
     return false;                                                              \
@@ -216,8 +967,8 @@
   /**                                                                          \
    * @brief Push multiple elements into FIFO.                                  \
    *                                                                           \
-   * Handles wrap_around automatically and uses memcpy() for efficient bulk    \
-   * transfer.                                                                 \
+   * Handles wrap_around automatically and uses GFIFO_MEMCPY() for efficient   \
+   * bulk transfer.                                                            \
    *                                                                           \
    * @param f FIFO instance.                                                   \
    * @param arr Source array.                                                  \
@@ -227,34 +978,37 @@
    * @return false Not enough free space.                                      \
    */                                                                          \
   static inline bool gfifo_##name##_push_array(                                \
-      gfifo_##name##_t *f, const type *arr, uint32_t len) {                    \
-    uint32_t in = *(volatile uint32_t *)&f->i;                                 \
-    uint32_t out = *(volatile uint32_t *)&f->o;                                \
-    uint32_t cap = f->cap;                                                     \
-    uint32_t msk = f->msk;                                                     \
-    uint32_t spc = cap - (in - out);                                           \
+      gfifo_##name##_t *f, const type *arr, idx_t len) {                       \
+    idx_t in = __GFIFO_LD_##mode(&f->i, relaxed);                              \
+    idx_t out = __GFIFO_PROD_OUT_##layout(mode, idx_t, f, in, len);            \
+    idx_t cap = f->cap;                                                        \
+    idx_t msk = f->msk;                                                        \
+    idx_t spc = cap - (in - out);                                              \
     if (len == 0) {                                                            \
       return true;                                                             \
     }                                                                          \
     if (len > spc) {                                                           \
+      __GFIFO_STAT_ADD(mode, f, st_push_fail, 1);                              \
       return false;                                                            \
     }                                                                          \
-    uint32_t ofst = in & msk;                                                  \
-    uint32_t l2e = cap - ofst;                                                 \
-    uint32_t l1 = (len < l2e) ? len : l2e;                                     \
-    memcpy(&f->buf[ofst], arr, l1 * sizeof(type));                             \
+    idx_t ofst = in & msk;                                                     \
+    idx_t l2e = __GFIFO_L2E_##layout(idx_t, f, ofst);                          \
+    idx_t l1 = (len < l2e) ? len : l2e;                                        \
+    GFIFO_MEMCPY(&f->buf[ofst], arr, l1 * sizeof(type));                       \
     if (len > l1) {                                                            \
-      memcpy(f->buf, &arr[l1], (len - l1) * sizeof(type));                     \
+      GFIFO_MEMCPY(f->buf, &arr[l1], (len - l1) * sizeof(type));               \
     }                                                                          \
-    *(volatile uint32_t *)&f->i = in + len;                                    \
+    __GFIFO_LAT_STAMP(mode, f, in, len);                                       \
+    __GFIFO_ST_##mode(&f->i, in + len, release);                               \
+    __GFIFO_STAT_PUSHED(mode, idx_t, f, len, len * sizeof(type), in, out);     \
     return true;                                                               \
   }                                                                            \
                                                                                \
   /**                                                                          \
    * @brief Pop multiple elements from FIFO.                                   \
    *                                                                           \
-   * Handles wrap_around automatically and uses memcpy() for efficient bulk    \
-   * transfer.                                                                 \
+   * Handles wrap_around automatically and uses GFIFO_MEMCPY() for efficient   \
+   * bulk transfer.                                                            \
    *                                                                           \
    * @param f FIFO instance.                                                   \
    * @param arr Destination array.                                             \
@@ -264,27 +1018,420 @@
    * @return false FIFO does not contain enough elements.                      \
    */                                                                          \
   static inline bool gfifo_##name##_pop_array(gfifo_##name##_t *f, type *arr,  \
-                                              uint32_t len) {                  \
-    uint32_t in = *(volatile uint32_t *)&f->i;                                 \
-    uint32_t out = *(volatile uint32_t *)&f->o;                                \
-    uint32_t cap = f->cap;                                                     \
-    uint32_t msk = f->msk;                                                     \
-    uint32_t cnt = in - out;                                                   \
+                                              idx_t len) {                     \
+    idx_t msk = f->msk;                                                        \
+    idx_t out;                                                                 \
     if (len == 0) {                                                            \
       return true;                                                             \
     }                                                                          \
-    if (cnt < len) {                                                           \
+    do {                                                                       \
+      out = __GFIFO_LD_##mode(&f->o, relaxed);                                 \
+      idx_t cnt = __GFIFO_CONS_IN_##layout(mode, idx_t, f, out, len) - out;    \
+      if (cnt < len) {                                                         \
+        __GFIFO_STAT_ADD(mode, f, st_pop_empty, 1);                            \
+        return false;                                                          \
+      }                                                                        \
+      idx_t ofst = out & msk;                                                  \
+      idx_t l2e = __GFIFO_L2E_##layout(idx_t, f, ofst);                        \
+      idx_t l1 = (len < l2e) ? len : l2e;                                      \
+      GFIFO_MEMCPY(arr, &f->buf[ofst], l1 * sizeof(type));                     \
+      if (len > l1) {                                                          \
+        GFIFO_MEMCPY(&arr[l1], f->buf, (len - l1) * sizeof(type));             \
+      }                                                                        \
+    } while (!__GFIFO_CONS_ST_##mode(&f->o, out, out + len));                  \
+    __GFIFO_STAT_POPPED(mode, f, len, len * sizeof(type));                     \
+    __GFIFO_LAT_POPPED(mode, idx_t, f, out + len);                             \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push as many elements as fit into FIFO.                            \
+   *                                                                           \
+   * Unlike push_array(), copies min(len, free space) elements instead of      \
+   * failing when the whole array does not fit.                                \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param arr Source array.                                                  \
+   * @param len Number of elements available in arr.                           \
+   *                                                                           \
+   * @return Number of elements pushed.                                        \
+   */                                                                          \
+  static inline idx_t gfifo_##name##_push_some(                                \
+      gfifo_##name##_t *f, const type *arr, idx_t len) {                       \
+    idx_t in = __GFIFO_LD_##mode(&f->i, relaxed);                              \
+    idx_t out = __GFIFO_PROD_OUT_##layout(mode, idx_t, f, in, len);            \
+    idx_t cap = f->cap;                                                        \
+    idx_t msk = f->msk;                                                        \
+    idx_t spc = cap - (in - out);                                              \
+    if (len > spc) {                                                           \
+      __GFIFO_STAT_ADD(mode, f, st_push_fail, 1);                              \
+      len = spc;                                                               \
+    }                                                                          \
+    if (len == 0) {                                                            \
+      return 0;                                                                \
+    }                                                                          \
+    idx_t ofst = in & msk;                                                     \
+    idx_t l2e = __GFIFO_L2E_##layout(idx_t, f, ofst);                          \
+    idx_t l1 = (len < l2e) ? len : l2e;                                        \
+    GFIFO_MEMCPY(&f->buf[ofst], arr, l1 * sizeof(type));                       \
+    if (len > l1) {                                                            \
+      GFIFO_MEMCPY(f->buf, &arr[l1], (len - l1) * sizeof(type));               \
+    }                                                                          \
+    __GFIFO_LAT_STAMP(mode, f, in, len);                                       \
+    __GFIFO_ST_##mode(&f->i, in + len, release);                               \
+    __GFIFO_STAT_PUSHED(mode, idx_t, f, len, len * sizeof(type), in, out);     \
+    return len;                                                                \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop as many elements as available from FIFO.                       \
+   *                                                                           \
+   * Unlike pop_array(), copies min(len, stored elements) elements instead     \
+   * of failing when the FIFO holds fewer than len elements.                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param arr Destination array.                                             \
+   * @param len Capacity of arr in elements.                                   \
+   *                                                                           \
+   * @return Number of elements popped.                                        \
+   */                                                                          \
+  static inline idx_t gfifo_##name##_pop_some(gfifo_##name##_t *f, type *arr,  \
+                                              idx_t len) {                     \
+    idx_t msk = f->msk;                                                        \
+    idx_t out, n;                                                              \
+    do {                                                                       \
+      out = __GFIFO_LD_##mode(&f->o, relaxed);                                 \
+      idx_t cnt = __GFIFO_CONS_IN_##layout(mode, idx_t, f, out, len) - out;    \
+      n = (len < cnt) ? len : cnt;                                             \
+      if (n == 0) {                                                            \
+        __GFIFO_STAT_ADD(mode, f, st_pop_empty, 1);                            \
+        return 0;                                                              \
+      }                                                                        \
+      idx_t ofst = out & msk;                                                  \
+      idx_t l2e = __GFIFO_L2E_##layout(idx_t, f, ofst);                        \
+      idx_t l1 = (n < l2e) ? n : l2e;                                          \
+      GFIFO_MEMCPY(arr, &f->buf[ofst], l1 * sizeof(type));                     \
+      if (n > l1) {                                                            \
+        GFIFO_MEMCPY(&arr[l1], f->buf, (n - l1) * sizeof(type));               \
+      }                                                                        \
+    } while (!__GFIFO_CONS_ST_##mode(&f->o, out, out + n));                    \
+    __GFIFO_STAT_POPPED(mode, f, n, n * sizeof(type));                         \
+    __GFIFO_LAT_POPPED(mode, idx_t, f, out + n);                               \
+    return n;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Callbacks used by push_batch()/pop_batch().                        \
+   *                                                                           \
+   * fill constructs one element in place and returns false to end the         \
+   * batch without publishing that slot. consume inspects one element and      \
+   * returns false to end the batch without consuming it.                      \
+   */                                                                          \
+  typedef bool (*gfifo_##name##_fill_fn)(type *e, void *ctx);                  \
+  typedef bool (*gfifo_##name##_consume_fn)(const type *e, void *ctx);         \
+                                                                               \
+  /**                                                                          \
+   * @brief Push up to n elements constructed in place by a callback.          \
+   *                                                                           \
+   * The free space is computed once, fill() is called for each slot in        \
+   * order directly on buf, and the write index is published once for the      \
+   * whole batch.                                                              \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param n Maximum number of elements to push.                              \
+   * @param fill Callback constructing one element.                            \
+   * @param ctx Opaque pointer passed to fill.                                 \
+   *                                                                           \
+   * @return Number of elements pushed.                                        \
+   */                                                                          \
+  static inline idx_t gfifo_##name##_push_batch(                               \
+      gfifo_##name##_t *f, idx_t n, gfifo_##name##_fill_fn fill, void *ctx) {  \
+    idx_t in = __GFIFO_LD_##mode(&f->i, relaxed);                              \
+    idx_t out = __GFIFO_PROD_OUT_##layout(mode, idx_t, f, in, n);              \
+    idx_t spc = f->cap - (in - out);                                           \
+    idx_t k;                                                                   \
+    if (n > spc) {                                                             \
+      __GFIFO_STAT_ADD(mode, f, st_push_fail, 1);                              \
+      n = spc;                                                                 \
+    }                                                                          \
+    for (k = 0; k < n; k++) {                                                  \
+      if (!fill(&f->buf[(in + k) & f->msk], ctx)) {                            \
+        break;                                                                 \
+      }                                                                        \
+    }                                                                          \
+    if (k > 0) {                                                               \
+      __GFIFO_LAT_STAMP(mode, f, in, k);                                       \
+      __GFIFO_ST_##mode(&f->i, in + k, release);                               \
+      __GFIFO_STAT_PUSHED(mode, idx_t, f, k, k * sizeof(type), in, out);       \
+    }                                                                          \
+    return k;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop up to max elements, handing each one to a callback.            \
+   *                                                                           \
+   * The stored count is computed once, consume() is called for each element   \
+   * in order directly on buf, and the read index is published once for the    \
+   * whole batch.                                                              \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param max Maximum number of elements to pop.                             \
+   * @param consume Callback consuming one element.                            \
+   * @param ctx Opaque pointer passed to consume.                              \
+   *                                                                           \
+   * @return Number of elements popped.                                        \
+   */                                                                          \
+  static inline idx_t gfifo_##name##_pop_batch(                                \
+      gfifo_##name##_t *f, idx_t max, gfifo_##name##_consume_fn consume,       \
+      void *ctx) {                                                             \
+    idx_t out = __GFIFO_LD_##mode(&f->o, relaxed);                             \
+    idx_t cnt = __GFIFO_CONS_IN_##layout(mode, idx_t, f, out, max) - out;      \
+    idx_t k;                                                                   \
+    if (cnt == 0) {                                                            \
+      __GFIFO_STAT_ADD(mode, f, st_pop_empty, 1);                              \
+    }                                                                          \
+    if (max > cnt) {                                                           \
+      max = cnt;                                                               \
+    }                                                                          \
+    for (k = 0; k < max; k++) {                                                \
+      if (!consume(&f->buf[(out + k) & f->msk], ctx)) {                        \
+        break;                                                                 \
+      }                                                                        \
+    }                                                                          \
+    if (k > 0 && !__GFIFO_CONS_ST_##mode(&f->o, out, out + k)) {               \
+      return 0;                                                                \
+    }                                                                          \
+    __GFIFO_STAT_POPPED(mode, f, k, k * sizeof(type));                         \
+    __GFIFO_LAT_POPPED(mode, idx_t, f, out + k);                               \
+    return k;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Reserve writable regions for a zero-copy push.                     \
+   *                                                                           \
+   * Reserves min(want, free space) elements starting at the write position    \
+   * and describes them as up to two contiguous regions: the first one ends    \
+   * at most at the end of buf, the second one (only when the reservation      \
+   * wraps) starts at buf[0]. The caller fills the regions directly (e.g.      \
+   * from DMA or recv()) and then publishes them with push_commit().           \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param want Number of elements requested.                                 \
+   * @param p1 Output start of the first region.                               \
+   * @param l1 Output length of the first region.                              \
+   * @param p2 Output start of the second region, NULL if none.                \
+   * @param l2 Output length of the second region, 0 if none.                  \
+   *                                                                           \
+   * @return Number of elements reserved (l1 + l2).                            \
+   */                                                                          \
+  static inline idx_t gfifo_##name##_push_reserve(                             \
+      gfifo_##name##_t *f, idx_t want, type **p1, idx_t *l1, type **p2,        \
+      idx_t *l2) {                                                             \
+    idx_t in = __GFIFO_LD_##mode(&f->i, relaxed);                              \
+    idx_t out = __GFIFO_PROD_OUT_##layout(mode, idx_t, f, in, want);           \
+    idx_t spc = f->cap - (in - out);                                           \
+    idx_t len = (want < spc) ? want : spc;                                     \
+    idx_t ofst = in & f->msk;                                                  \
+    if (want > spc) {                                                          \
+      __GFIFO_STAT_ADD(mode, f, st_push_fail, 1);                              \
+    }                                                                          \
+    idx_t l2e = __GFIFO_L2E_##layout(idx_t, f, ofst);                          \
+    idx_t n1 = (len < l2e) ? len : l2e;                                        \
+    *p1 = &f->buf[ofst];                                                       \
+    *l1 = n1;                                                                  \
+    *p2 = (len > n1) ? f->buf : NULL;                                          \
+    *l2 = len - n1;                                                            \
+    return len;                                                                \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Publish elements written into regions from push_reserve().         \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param n Number of elements to publish, starting at the first region.     \
+   *                                                                           \
+   * @return true  Elements published.                                         \
+   * @return false n exceeds the free space.                                   \
+   */                                                                          \
+  static inline bool gfifo_##name##_push_commit(gfifo_##name##_t *f,           \
+                                                idx_t n) {                     \
+    idx_t in = __GFIFO_LD_##mode(&f->i, relaxed);                              \
+    idx_t out = __GFIFO_PROD_OUT_##layout(mode, idx_t, f, in, n);              \
+    if (n > (idx_t)(f->cap - (in - out))) {                                    \
+      __GFIFO_STAT_ADD(mode, f, st_push_fail, 1);                              \
+      return false;                                                            \
+    }                                                                          \
+    __GFIFO_LAT_STAMP(mode, f, in, n);                                         \
+    __GFIFO_ST_##mode(&f->i, in + n, release);                                 \
+    __GFIFO_STAT_PUSHED(mode, idx_t, f, n, n * sizeof(type), in, out);         \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Get the readable regions for a zero-copy pop.                      \
+   *                                                                           \
+   * Describes the stored elements as up to two contiguous regions: the        \
+   * first one starts at the read position and ends at most at the end of      \
+   * buf, the second one (only when the data wraps) starts at buf[0]. The      \
+   * elements stay in the FIFO until they are consumed with release() (or      \
+   * drop()), so the regions can be passed straight to write()/writev() or     \
+   * a parser.                                                                 \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param p1 Output start of the first region.                               \
+   * @param l1 Output length of the first region.                              \
+   * @param p2 Output start of the second region, NULL if none.                \
+   * @param l2 Output length of the second region, 0 if none.                  \
+   *                                                                           \
+   * @return Number of readable elements (l1 + l2).                            \
+   */                                                                          \
+  static inline idx_t gfifo_##name##_readable_spans(                           \
+      gfifo_##name##_t *f, const type **p1, idx_t *l1, const type **p2,        \
+      idx_t *l2) {                                                             \
+    idx_t out = __GFIFO_LD_##mode(&f->o, relaxed);                             \
+    idx_t len = __GFIFO_CONS_IN_##layout(mode, idx_t, f, out, f->cap) - out;   \
+    idx_t ofst = out & f->msk;                                                 \
+    idx_t l2e = __GFIFO_L2E_##layout(idx_t, f, ofst);                          \
+    idx_t n1 = (len < l2e) ? len : l2e;                                        \
+    *p1 = &f->buf[ofst];                                                       \
+    *l1 = n1;                                                                  \
+    *p2 = (len > n1) ? f->buf : NULL;                                          \
+    *l2 = len - n1;                                                            \
+    return len;                                                                \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Consume elements previously obtained via readable_spans().         \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param n Number of elements to consume, starting at the first region.     \
+   *                                                                           \
+   * @return true  Elements consumed.                                          \
+   * @return false FIFO does not contain n elements.                           \
+   */                                                                          \
+  static inline bool gfifo_##name##_release(gfifo_##name##_t *f,               \
+                                            idx_t n) {                         \
+    idx_t out = __GFIFO_LD_##mode(&f->o, relaxed);                             \
+    idx_t in = __GFIFO_CONS_IN_##layout(mode, idx_t, f, out, n);               \
+    if (n > (idx_t)(in - out)) {                                               \
+      __GFIFO_STAT_ADD(mode, f, st_pop_empty, 1);                              \
       return false;                                                            \
     }                                                                          \
-    uint32_t ofst = out & msk;                                                 \
+    if (!__GFIFO_CONS_ST_##mode(&f->o, out, out + n)) {                        \
+      return false;                                                            \
+    }                                                                          \
+    __GFIFO_STAT_POPPED(mode, f, n, n * sizeof(type));                         \
+    __GFIFO_LAT_POPPED(mode, idx_t, f, out + n);                               \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Take a snapshot of the FIFO statistics.                            \
+   *                                                                           \
+   * Counters are read individually with relaxed ordering, so a snapshot       \
+   * taken while the FIFO is in use is not atomic as a whole. Safe to call     \
+   * from any thread.                                                          \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param s Output snapshot, zeroed when statistics are compiled out.        \
+   *                                                                           \
+   * @return true  Statistics are available (GFIFO_CFG_STATS).                 \
+   * @return false Statistics are compiled out.                                \
+   */                                                                          \
+  static inline bool gfifo_##name##_stats(const gfifo_##name##_t *f,           \
+                                          gfifo_stats_t *s) {                  \
+    (void)f;                                                                   \
+    return __GFIFO_STATS_READ(mode, f, s);                                     \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Take a snapshot of the queueing delay histogram.                   \
+   *                                                                           \
+   * Buckets are read individually with relaxed ordering. Safe to call from    \
+   * any thread.                                                               \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param s Output snapshot, zeroed when the histogram is compiled out.      \
+   *                                                                           \
+   * @return true  Histogram is available (GFIFO_CFG_LATENCY).                 \
+   * @return false Histogram is compiled out.                                  \
+   */                                                                          \
+  static inline bool gfifo_##name##_latency(const gfifo_##name##_t *f,         \
+                                            gfifo_latency_t *s) {              \
+    (void)f;                                                                   \
+    __GFIFO_LAT_READ(mode, f, s);                                              \
+    return __GFIFO_LAT_ENABLED;                                                \
+  }
+
+#ifdef GFIFO_HAS_ATOMICS
+/*
+ * Producer side overwrite operations of DECLARE_GFIFO_TYPE_LOSSY(). The CAS
+ * on o is acquire so the following writes to buf cannot be observed before
+ * the consumer's last commit of o.
+ */
+#define __GFIFO_LOSSY_DECLARE(name, type)                                      \
+  /**                                                                          \
+   * @brief Push multiple elements, overwriting the oldest ones if needed.     \
+   *                                                                           \
+   * When len exceeds the capacity only the last cap elements of arr are       \
+   * stored.                                                                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param arr Source array.                                                  \
+   * @param len Number of elements to push.                                    \
+   *                                                                           \
+   * @return Number of elements lost (overwritten in the FIFO or skipped       \
+   *         from arr).                                                        \
+   */                                                                          \
+  static inline uint32_t gfifo_##name##_push_array_overwrite(                  \
+      gfifo_##name##_t *f, const type *arr, uint32_t len) {                    \
+    uint32_t in = atomic_load_explicit(&f->i, memory_order_relaxed);           \
+    uint32_t out = atomic_load_explicit(&f->o, memory_order_acquire);          \
+    uint32_t cap = f->cap;                                                     \
+    uint32_t lost = 0;                                                         \
+    if (len > cap) {                                                           \
+      lost = len - cap;                                                        \
+      arr += lost;                                                             \
+      len = cap;                                                               \
+    }                                                                          \
+    while (cap - (in - out) < len) {                                           \
+      uint32_t nout = in + len - cap;                                          \
+      if (atomic_compare_exchange_weak_explicit(&f->o, &out, nout,             \
+                                                memory_order_acquire,          \
+                                                memory_order_acquire)) {       \
+        lost += nout - out;                                                    \
+        break;                                                                 \
+      }                                                                        \
+    }                                                                          \
+    if (len == 0) {                                                            \
+      __GFIFO_STAT_ADD(LOSSY, f, st_lost, lost);                               \
+      return lost;                                                             \
+    }                                                                          \
+    uint32_t ofst = in & f->msk;                                               \
     uint32_t l2e = cap - ofst;                                                 \
     uint32_t l1 = (len < l2e) ? len : l2e;                                     \
-    memcpy(arr, &f->buf[ofst], l1 * sizeof(type));                             \
+    GFIFO_MEMCPY(&f->buf[ofst], arr, l1 * sizeof(type));                       \
     if (len > l1) {                                                            \
-      memcpy(&arr[l1], f->buf, (len - l1) * sizeof(type));                     \
+      GFIFO_MEMCPY(f->buf, &arr[l1], (len - l1) * sizeof(type));               \
     }                                                                          \
-    *(volatile uint32_t *)&f->o = out + len;                                   \
-    return true;                                                               \
+    atomic_store_explicit(&f->i, in + len, memory_order_release);              \
+    __GFIFO_STAT_PUSHED(LOSSY, uint32_t, f, len, len * sizeof(type), in, out); \
+    __GFIFO_STAT_ADD(LOSSY, f, st_lost, lost);                                 \
+    return lost;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push a single element, overwriting the oldest one if full.         \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param e Pointer to element to push.                                      \
+   *                                                                           \
+   * @return Number of elements lost (0 or 1).                                 \
+   */                                                                          \
+  static inline uint32_t gfifo_##name##_push_overwrite(gfifo_##name##_t *f,    \
+                                                       const type *e) {        \
+    return gfifo_##name##_push_array_overwrite(f, e, 1);                       \
   }
+#endif
 
 #endif //! __GFIFO_H__
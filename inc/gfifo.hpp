@@ -0,0 +1,317 @@
+/**
+ * @file gfifo.hpp
+ * @brief C++17 SPSC ring templates with move semantics.
+ *
+ * @details
+ * The C macros copy elements by assignment and memcpy(), which is only
+ * correct for trivially copyable types. gfifo::ring constructs elements in
+ * place in uninitialized storage and moves them in and out, so std::string,
+ * std::vector or std::unique_ptr payloads are never deep copied and
+ * nothing is default-constructed:
+ *   - gfifo::ring<T, N>: capacity N fixed at compile time, storage inline
+ *     (like sfifo.h); capacity() is a constant expression;
+ *   - gfifo::ring<T>:    capacity chosen at construction, storage on the
+ *     heap (like gfifo.h).
+ *
+ * The index scheme is the one of DECLARE_GFIFO_TYPE_ATOMIC_CL(): free-running
+ * 32-bit indices with acquire/release ordering on separate cache lines, each
+ * side caching the other side's index. Bulk push_some()/pop_some() use at
+ * most two memcpy() calls when T is trivially copyable and fall back to
+ * per-element construction otherwise.
+ *
+ * Usage:
+ *   gfifo::ring<std::string, 1024> q;
+ *   q.try_push(std::move(s));          // producer thread
+ *   q.emplace(16, 'x');
+ *   std::string out;
+ *   if (q.try_pop(out)) { ... }        // consumer thread
+ *
+ * Constraints:
+ *   - capacity must be a power of two
+ *   - one producer thread and one consumer thread
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_HPP__
+#define __GFIFO_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Cache line size used to separate producer and consumer indices.
+ */
+#ifndef GFIFO_CACHELINE
+#define GFIFO_CACHELINE 64
+#endif
+
+namespace gfifo {
+
+/** Capacity argument of ring<T> selecting a run-time capacity. */
+inline constexpr std::size_t dynamic_capacity = 0;
+
+namespace detail {
+
+/* Inline storage for N elements, none of them constructed. */
+template <typename T, std::size_t N> class storage {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "capacity must be a power of 2");
+  static_assert(N <= (std::size_t{1} << 31), "capacity must fit the index");
+
+public:
+  static constexpr std::uint32_t capacity() noexcept { return N; }
+
+protected:
+  storage() noexcept = default;
+  void *slot(std::uint32_t k) noexcept { return buf_ + k * sizeof(T); }
+
+private:
+  alignas(T) unsigned char buf_[N * sizeof(T)];
+};
+
+/* Heap storage for a capacity chosen at construction. */
+template <typename T> class storage<T, dynamic_capacity> {
+public:
+  std::uint32_t capacity() const noexcept { return cap_; }
+
+protected:
+  explicit storage(std::uint32_t cap) : cap_(cap) {
+    if (cap == 0 || (cap & (cap - 1)) != 0 || cap > (1u << 31)) {
+      throw std::invalid_argument("gfifo::ring capacity must be a power of 2");
+    }
+    buf_ = static_cast<unsigned char *>(::operator new(
+        std::size_t{cap} * sizeof(T), std::align_val_t{alignof(T)}));
+  }
+  ~storage() { ::operator delete(buf_, std::align_val_t{alignof(T)}); }
+  void *slot(std::uint32_t k) noexcept { return buf_ + k * sizeof(T); }
+
+private:
+  std::uint32_t cap_;
+  unsigned char *buf_;
+};
+
+} // namespace detail
+
+/**
+ * @brief Lock-free SPSC ring of T.
+ *
+ * @tparam T Element type, must be nothrow move constructible.
+ * @tparam N Capacity (power of two), or dynamic_capacity to pass it to the
+ *           constructor.
+ *
+ * emplace/try_push/push_some must only be called by the producer,
+ * try_pop/front/pop/pop_some/clear only by the consumer.
+ */
+template <typename T, std::size_t N = dynamic_capacity>
+class ring : public detail::storage<T, N> {
+  static_assert(std::is_nothrow_move_constructible_v<T>,
+                "gfifo::ring elements must be nothrow move constructible");
+
+  using base = detail::storage<T, N>;
+  static constexpr bool trivial = std::is_trivially_copyable_v<T>;
+
+public:
+  using value_type = T;
+  using size_type = std::uint32_t;
+
+  /** Construct an empty ring with compile-time capacity N. */
+  template <std::size_t M = N,
+            std::enable_if_t<M != dynamic_capacity, int> = 0>
+  ring() noexcept {}
+
+  /**
+   * @brief Construct an empty ring with run-time capacity.
+   *
+   * @throw std::invalid_argument capacity is not a power of two.
+   */
+  template <std::size_t M = N,
+            std::enable_if_t<M == dynamic_capacity, int> = 0>
+  explicit ring(size_type capacity) : base(capacity) {}
+
+  ring(const ring &) = delete;
+  ring &operator=(const ring &) = delete;
+
+  /** Destroys the elements still stored. */
+  ~ring() { clear(); }
+
+  using base::capacity;
+
+  /** Number of stored elements; exact only when both sides are idle. */
+  size_type size() const noexcept {
+    return i_.load(std::memory_order_acquire) -
+           o_.load(std::memory_order_acquire);
+  }
+  bool empty() const noexcept { return size() == 0; }
+  bool full() const noexcept { return size() == capacity(); }
+
+  /**
+   * @brief Construct an element in place at the back.
+   *
+   * @return true  Element constructed and published.
+   * @return false Ring is full, args are left untouched.
+   */
+  template <typename... Args> bool emplace(Args &&...args) {
+    size_type in = i_.load(std::memory_order_relaxed);
+    if (free_space(in, 1) == 0) {
+      return false;
+    }
+    ::new (slot_at(in)) T(std::forward<Args>(args)...);
+    i_.store(in + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Copy an element in; false if the ring is full. */
+  bool try_push(const T &e) { return emplace(e); }
+
+  /** Move an element in; false (and e untouched) if the ring is full. */
+  bool try_push(T &&e) noexcept { return emplace(std::move(e)); }
+
+  /**
+   * @brief Copy up to len elements in.
+   *
+   * If a copy constructor throws, the elements copied before it are
+   * published and the exception is rethrown.
+   *
+   * @return Number of elements pushed.
+   */
+  size_type push_some(const T *src, size_type len) {
+    size_type in = i_.load(std::memory_order_relaxed);
+    size_type n = free_space(in, len);
+    if (n > len) {
+      n = len;
+    }
+    size_type ofst = in & (capacity() - 1);
+    size_type l1 = capacity() - ofst < n ? capacity() - ofst : n;
+    if constexpr (trivial) {
+      std::memcpy(slot_at(in), src, l1 * sizeof(T));
+      std::memcpy(slot_at(0), src + l1, (n - l1) * sizeof(T));
+    } else {
+      size_type k = 0;
+      try {
+        for (; k < n; k++) {
+          ::new (slot_at(in + k)) T(src[k]);
+        }
+      } catch (...) {
+        i_.store(in + k, std::memory_order_release);
+        throw;
+      }
+    }
+    i_.store(in + n, std::memory_order_release);
+    return n;
+  }
+
+  /**
+   * @brief Move the front element out.
+   *
+   * @param out Move-assigned from the front element, which is destroyed.
+   *
+   * @return true  Element popped.
+   * @return false Ring is empty.
+   */
+  bool try_pop(T &out) noexcept(std::is_nothrow_move_assignable_v<T>) {
+    size_type out_i = o_.load(std::memory_order_relaxed);
+    if (used_space(out_i, 1) == 0) {
+      return false;
+    }
+    T *e = elem_at(out_i);
+    out = std::move(*e);
+    e->~T();
+    o_.store(out_i + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Front element, nullptr if the ring is empty. */
+  T *front() noexcept {
+    size_type out_i = o_.load(std::memory_order_relaxed);
+    return used_space(out_i, 1) == 0 ? nullptr : elem_at(out_i);
+  }
+
+  /** Destroy the front element; false if the ring is empty. */
+  bool pop() noexcept {
+    size_type out_i = o_.load(std::memory_order_relaxed);
+    if (used_space(out_i, 1) == 0) {
+      return false;
+    }
+    elem_at(out_i)->~T();
+    o_.store(out_i + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Move up to len elements out into dst.
+   *
+   * @return Number of elements popped.
+   */
+  size_type pop_some(T *dst, size_type len) noexcept(
+      std::is_nothrow_move_assignable_v<T>) {
+    size_type out_i = o_.load(std::memory_order_relaxed);
+    size_type n = used_space(out_i, len);
+    if (n > len) {
+      n = len;
+    }
+    size_type ofst = out_i & (capacity() - 1);
+    size_type l1 = capacity() - ofst < n ? capacity() - ofst : n;
+    if constexpr (trivial) {
+      std::memcpy(dst, slot_at(out_i), l1 * sizeof(T));
+      std::memcpy(dst + l1, slot_at(0), (n - l1) * sizeof(T));
+    } else {
+      for (size_type k = 0; k < n; k++) {
+        T *e = elem_at(out_i + k);
+        dst[k] = std::move(*e);
+        e->~T();
+      }
+    }
+    o_.store(out_i + n, std::memory_order_release);
+    return n;
+  }
+
+  /** Destroy all stored elements. */
+  void clear() noexcept {
+    while (pop()) {
+    }
+  }
+
+private:
+  void *slot_at(size_type idx) noexcept {
+    return base::slot(idx & (capacity() - 1));
+  }
+  T *elem_at(size_type idx) noexcept {
+    return std::launder(static_cast<T *>(slot_at(idx)));
+  }
+
+  /* Producer: free slots, reloading o only when the cached view is short. */
+  size_type free_space(size_type in, size_type need) noexcept {
+    size_type n = capacity() - (in - oc_);
+    if (n < need) {
+      oc_ = o_.load(std::memory_order_acquire);
+      n = capacity() - (in - oc_);
+    }
+    return n;
+  }
+
+  /* Consumer: stored elements, reloading i only when the cached view is
+   * short. */
+  size_type used_space(size_type out, size_type need) noexcept {
+    size_type n = ic_ - out;
+    if (n < need) {
+      ic_ = i_.load(std::memory_order_acquire);
+      n = ic_ - out;
+    }
+    return n;
+  }
+
+  alignas(GFIFO_CACHELINE) std::atomic<size_type> i_{0};
+  size_type oc_{0};
+  alignas(GFIFO_CACHELINE) std::atomic<size_type> o_{0};
+  size_type ic_{0};
+};
+
+} // namespace gfifo
+
+#endif //! __GFIFO_HPP__
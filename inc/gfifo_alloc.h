@@ -0,0 +1,228 @@
+/**
+ * @file gfifo_alloc.h
+ * @brief Hugepage and NUMA aware storage allocation for gfifo types.
+ *
+ * @details
+ * gfifo_<name>_init() takes a caller-provided buffer. For large rings the
+ * buffer should be hugepage backed (fewer TLB misses), placed on the NUMA
+ * node of the core that touches it most, and faulted in before the first
+ * push so the hot path never takes a page fault. DECLARE_GFIFO_ALLOC()
+ * generates, for an existing gfifo type:
+ *   - gfifo_<name>_create(size, flags): allocate a cache-line aligned FIFO
+ *     and its storage and initialize it;
+ *   - gfifo_<name>_destroy(f): release both.
+ *
+ * flags is a combination of:
+ *   - GFIFO_ALLOC_HUGEPAGE: use MAP_HUGETLB pages of GFIFO_HUGEPAGE_SIZE,
+ *     falling back to a GFIFO_HUGEPAGE_SIZE aligned mapping advised for
+ *     transparent hugepages when none are reserved;
+ *   - GFIFO_ALLOC_POPULATE: pre-fault the whole buffer;
+ *   - GFIFO_ALLOC_NODE(n): bind the buffer to NUMA node n before it is
+ *     faulted in. gfifo_alloc_current_node() returns the node of the
+ *     calling CPU, e.g. to be called on the consumer thread.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC_CL(rx, struct pkt);
+ *   DECLARE_GFIFO_ALLOC(rx, struct pkt);
+ *   gfifo_rx_t *f = gfifo_rx_create(1u << 20, GFIFO_ALLOC_HUGEPAGE |
+ *                                   GFIFO_ALLOC_POPULATE |
+ *                                   GFIFO_ALLOC_NODE(node));
+ *   ...
+ *   gfifo_rx_destroy(f);
+ *
+ * Not for the MIRROR and SHM layouts, which bring their own storage.
+ * Requires Linux (mmap, mbind). Under -std=c11, define _GNU_SOURCE or
+ * _DEFAULT_SOURCE before the first #include for syscall() and MAP_ANONYMOUS.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_ALLOC_H__
+#define __GFIFO_ALLOC_H__
+
+#include "gfifo.h"
+
+#if defined(__linux__)
+
+#include <limits.h>
+#include <linux/mempolicy.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/** Huge page size used with GFIFO_ALLOC_HUGEPAGE. */
+#ifndef GFIFO_HUGEPAGE_SIZE
+#define GFIFO_HUGEPAGE_SIZE ((size_t)2u << 20)
+#endif
+
+/** Back the buffer with huge pages. */
+#define GFIFO_ALLOC_HUGEPAGE (1u << 0)
+
+/** Fault the whole buffer in at creation time. */
+#define GFIFO_ALLOC_POPULATE (1u << 1)
+
+/** Bind the buffer to NUMA node n (0 <= n < 1024). */
+#define GFIFO_ALLOC_NODE(n) (((uint32_t)(n) + 1u) << 16)
+
+/* Upper bound of GFIFO_ALLOC_NODE() nodes, size of the mbind() mask. */
+#define __GFIFO_ALLOC_MAX_NODES 1024
+
+/**
+ * @brief NUMA node of the CPU the caller currently runs on.
+ *
+ * @return Node number, 0 if it cannot be determined.
+ */
+static inline int gfifo_alloc_current_node(void) {
+  unsigned cpu = 0, node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0) {
+    return 0;
+  }
+  return (int)node;
+}
+
+/* Map `len` bytes aligned to `align`, trimming the over-mapped ends. */
+static inline void *__gfifo_alloc_map_aligned(size_t len, size_t align) {
+  uint8_t *p = mmap(NULL, len + align, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    return NULL;
+  }
+  size_t head = (align - ((uintptr_t)p & (align - 1))) & (align - 1);
+  if (head != 0) {
+    munmap(p, head);
+  }
+  munmap(p + head + len, align - head);
+  return p + head;
+}
+
+/**
+ * @brief Map storage according to GFIFO_ALLOC_* flags.
+ *
+ * NUMA binding is applied before any page is touched; it is a placement
+ * hint and silently ignored where mbind() is unavailable.
+ *
+ * @param bytes   Requested size.
+ * @param flags   GFIFO_ALLOC_* flags.
+ * @param map_len Output mapping size to pass to gfifo_alloc_unmap().
+ *
+ * @return Base of the zero-filled mapping, NULL on failure.
+ */
+static inline void *gfifo_alloc_map(size_t bytes, uint32_t flags,
+                                    size_t *map_len) {
+  long pg = sysconf(_SC_PAGESIZE);
+  uint32_t node = flags >> 16;
+  bool faulted = false;
+  uint8_t *p = NULL;
+  size_t len;
+  if (bytes == 0 || pg <= 0 || node > __GFIFO_ALLOC_MAX_NODES) {
+    return NULL;
+  }
+  if (flags & GFIFO_ALLOC_HUGEPAGE) {
+    len = (bytes + GFIFO_HUGEPAGE_SIZE - 1) & ~(GFIFO_HUGEPAGE_SIZE - 1);
+    int populate = (flags & GFIFO_ALLOC_POPULATE) && !node ? MAP_POPULATE : 0;
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+    if (p != MAP_FAILED) {
+      faulted = populate != 0;
+    } else if ((p = __gfifo_alloc_map_aligned(len, GFIFO_HUGEPAGE_SIZE)) !=
+               NULL) {
+      madvise(p, len, MADV_HUGEPAGE);
+    }
+  } else {
+    len = (bytes + (size_t)pg - 1) & ~((size_t)pg - 1);
+    p = __gfifo_alloc_map_aligned(len, (size_t)pg);
+  }
+  if (p == NULL) {
+    return NULL;
+  }
+  if (node) {
+    unsigned long mask[__GFIFO_ALLOC_MAX_NODES / (sizeof(long) * CHAR_BIT)];
+    memset(mask, 0, sizeof(mask));
+    mask[(node - 1) / (sizeof(long) * CHAR_BIT)] |=
+        1ul << ((node - 1) % (sizeof(long) * CHAR_BIT));
+    syscall(SYS_mbind, p, len, MPOL_BIND, mask, sizeof(mask) * CHAR_BIT + 1,
+            0);
+  }
+  if ((flags & GFIFO_ALLOC_POPULATE) && !faulted) {
+    for (size_t k = 0; k < len; k += (size_t)pg) {
+      ((volatile uint8_t *)p)[k] = 0;
+    }
+  }
+  *map_len = len;
+  return p;
+}
+
+/**
+ * @brief Release a mapping obtained from gfifo_alloc_map().
+ *
+ * @param base    Base returned by gfifo_alloc_map(), may be NULL.
+ * @param map_len Size returned by gfifo_alloc_map().
+ */
+static inline void gfifo_alloc_unmap(void *base, size_t map_len) {
+  if (base != NULL) {
+    munmap(base, map_len);
+  }
+}
+
+/**
+ * @brief  Declare create/destroy helpers for an existing gfifo type.
+ *
+ * @param name  Name of a gfifo type declared with a DECLARE_GFIFO_TYPE*
+ *              macro using the PACKED or CL layout.
+ * @param type  Element type of that FIFO type.
+ */
+#define DECLARE_GFIFO_ALLOC(name, type)                                        \
+  typedef struct {                                                             \
+    gfifo_##name##_t f;                                                        \
+    size_t map_len;                                                            \
+  } __gfifo_##name##_alloc_t;                                                  \
+                                                                               \
+  /**                                                                          \
+   * @brief Allocate and initialize a FIFO and its storage.                    \
+   *                                                                           \
+   * @param size Capacity in elements, must be a power of two representable    \
+   *             in the index type.                                            \
+   * @param flags GFIFO_ALLOC_* flags.                                         \
+   *                                                                           \
+   * @return FIFO instance, NULL on invalid size or allocation failure.        \
+   */                                                                          \
+  static inline gfifo_##name##_t *gfifo_##name##_create(size_t size,           \
+                                                        uint32_t flags) {      \
+    __gfifo_##name##_alloc_t *a;                                               \
+    size_t align = _Alignof(__gfifo_##name##_alloc_t);                         \
+    if (align < GFIFO_CACHELINE) {                                             \
+      align = GFIFO_CACHELINE;                                                 \
+    }                                                                          \
+    if (size == 0 || (size & (size - 1)) != 0 ||                               \
+        size > SIZE_MAX / sizeof(type) ||                                      \
+        posix_memalign((void **)&a, align, sizeof(*a)) != 0) {                 \
+      return NULL;                                                             \
+    }                                                                          \
+    type *buf = (type *)gfifo_alloc_map(size * sizeof(type), flags,            \
+                                        &a->map_len);                          \
+    if (!gfifo_##name##_init(&a->f, buf, size) || a->f.cap != size) {          \
+      gfifo_alloc_unmap(buf, a->map_len);                                      \
+      free(a);                                                                 \
+      return NULL;                                                             \
+    }                                                                          \
+    return &a->f;                                                              \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Release a FIFO obtained from create().                             \
+   *                                                                           \
+   * @param f FIFO instance, may be NULL; must not be used afterwards.         \
+   */                                                                          \
+  static inline void gfifo_##name##_destroy(gfifo_##name##_t *f) {             \
+    __gfifo_##name##_alloc_t *a = (__gfifo_##name##_alloc_t *)f;               \
+    if (a != NULL) {                                                           \
+      gfifo_alloc_unmap(a->f.buf, a->map_len);                                 \
+      free(a);                                                                 \
+    }                                                                          \
+  }
+
+#endif // __linux__
+
+#endif //! __GFIFO_ALLOC_H__
@@ -0,0 +1,323 @@
+/**
+ * @file gfifo_bcast.h
+ * @brief Broadcast ring: one producer, several independent readers.
+ *
+ * @details
+ * The producer writes every element into buf once and each of r readers
+ * consumes all of them through its own cursor, instead of pushing the
+ * same data into r separate FIFOs:
+ *   - reader k owns o[k] on its own cache line and publishes it with
+ *     release after reading, like the consumer of an atomic gfifo;
+ *   - free space is computed from the slowest attached reader. The
+ *     producer caches that minimum and only rescans the cursors when the
+ *     cached view says the ring is full.
+ *
+ * Lagging readers are handled by the policy given to init():
+ *   - GFIFO_BCAST_BLOCK:  pushes fail while the slowest reader has not made
+ *     room, as with a plain gfifo;
+ *   - GFIFO_BCAST_DETACH: a reader that would block the push is detached
+ *     and the producer overwrites its unread elements. The reader notices
+ *     on its next pop (which returns nothing and discards anything it just
+ *     copied), checks is_attached() and calls attach() to resume from the
+ *     newest element.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_BCAST_TYPE(ev, struct event, 3);
+ *   static struct event storage[4096];
+ *   gfifo_bcast_ev_t b;
+ *   gfifo_bcast_ev_init(&b, storage, 4096, GFIFO_BCAST_DETACH);
+ *   gfifo_bcast_ev_push_array(&b, evs, n);              // producer thread
+ *   n = gfifo_bcast_ev_pop_some(&b, 1, out, 64);        // reader 1 thread
+ *
+ * Requires C11 <stdatomic.h>.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_BCAST_H__
+#define __GFIFO_BCAST_H__
+
+#include "gfifo.h"
+
+#ifdef GFIFO_HAS_ATOMICS
+
+/** Pushes fail while the slowest attached reader has not made room. */
+#define GFIFO_BCAST_BLOCK 0
+/** Readers that would block a push are detached. */
+#define GFIFO_BCAST_DETACH 1
+
+/**
+ * @brief  Declare a broadcast ring type.
+ *
+ * @param name  Suffix used to form the ring type name.
+ * @param type  Element type.
+ * @param r     Number of readers, a compile-time constant.
+ *
+ * The generated type is:
+ *     gfifo_bcast_<name>_t
+ *
+ * push/push_array/push_some must only be called by the producer; the
+ * functions taking a reader index k only by the thread of reader k.
+ *
+ * Detaching pairs a release fence of the producer, issued before it
+ * overwrites the reader's elements, with an acquire fence of the reader
+ * after its copy: a reader that still sees itself attached after the copy
+ * read no overwritten element. attach() publishes the cursor, then issues
+ * a seq_cst fence paired with the one of the producer's rescan, so the
+ * producer either sees the reader or had cached a minimum no older than
+ * the position the reader starts from.
+ */
+#define DECLARE_GFIFO_BCAST_TYPE(name, type, r)                                \
+  typedef struct {                                                             \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) _Atomic uint32_t o;                       \
+    _Atomic uint32_t live;                                                     \
+    uint32_t ic;                                                               \
+  } __gfifo_bcast_##name##_reader_t;                                           \
+                                                                               \
+  typedef struct {                                                             \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) type *buf;                                \
+    uint32_t cap;                                                              \
+    uint32_t msk;                                                              \
+    int policy;                                                                \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) _Atomic uint32_t i;                       \
+    uint32_t oc;                                                               \
+    __gfifo_bcast_##name##_reader_t rd[r];                                     \
+  } gfifo_bcast_##name##_t;                                                    \
+                                                                               \
+  /**                                                                          \
+   * @brief Initialize broadcast ring with user_provided storage.              \
+   *                                                                           \
+   * All readers start attached at the first element. Must not be called       \
+   * while other threads access the ring.                                      \
+   *                                                                           \
+   * @param b Ring instance.                                                   \
+   * @param buf Storage for size elements.                                     \
+   * @param size Capacity in elements, must be a power of two <= 2^31.         \
+   * @param policy GFIFO_BCAST_BLOCK or GFIFO_BCAST_DETACH.                    \
+   *                                                                           \
+   * @return true  Initialization succeeded.                                   \
+   * @return false Invalid size or NULL buffer.                                \
+   */                                                                          \
+  static inline bool gfifo_bcast_##name##_init(                                \
+      gfifo_bcast_##name##_t *b, type *buf, uint32_t size, int policy) {       \
+    if (size == 0 || (size & (size - 1)) != 0 || size > (1u << 31) ||          \
+        buf == NULL) {                                                         \
+      return false;                                                            \
+    }                                                                          \
+    b->buf = buf;                                                              \
+    b->cap = size;                                                             \
+    b->msk = size - 1;                                                         \
+    b->policy = policy;                                                        \
+    b->oc = 0;                                                                 \
+    for (uint32_t k = 0; k < (r); k++) {                                       \
+      atomic_store_explicit(&b->rd[k].o, 0, memory_order_relaxed);             \
+      atomic_store_explicit(&b->rd[k].live, 1, memory_order_relaxed);          \
+      b->rd[k].ic = 0;                                                         \
+    }                                                                          \
+    atomic_store_explicit(&b->i, 0, memory_order_release);                     \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /* Producer: free slots for need elements at in, rescanning the readers      \
+   * (and detaching the ones in the way, if the policy says so) only when      \
+   * the cached minimum cursor is too old. */                                  \
+  static inline uint32_t __gfifo_bcast_##name##_space(                         \
+      gfifo_bcast_##name##_t *b, uint32_t in, uint32_t need) {                 \
+    uint32_t n = b->cap - (in - b->oc);                                        \
+    if (n >= need) {                                                           \
+      return n;                                                                \
+    }                                                                          \
+    atomic_thread_fence(memory_order_seq_cst);                                 \
+    bool cut = false;                                                          \
+    uint32_t lo = in;                                                          \
+    for (uint32_t k = 0; k < (r); k++) {                                       \
+      __gfifo_bcast_##name##_reader_t *rd = &b->rd[k];                         \
+      if (!atomic_load_explicit(&rd->live, memory_order_acquire)) {            \
+        continue;                                                              \
+      }                                                                        \
+      uint32_t o = atomic_load_explicit(&rd->o, memory_order_acquire);         \
+      if (b->policy == GFIFO_BCAST_DETACH && b->cap - (in - o) < need) {       \
+        atomic_store_explicit(&rd->live, 0, memory_order_relaxed);             \
+        cut = true;                                                            \
+        continue;                                                              \
+      }                                                                        \
+      if ((uint32_t)(in - o) > (uint32_t)(in - lo)) {                          \
+        lo = o;                                                                \
+      }                                                                        \
+    }                                                                          \
+    if (cut) {                                                                 \
+      atomic_thread_fence(memory_order_release);                               \
+    }                                                                          \
+    b->oc = lo;                                                                \
+    return b->cap - (in - lo);                                                 \
+  }                                                                            \
+                                                                               \
+  /* Producer: copy len elements to position in and publish them. */           \
+  static inline void __gfifo_bcast_##name##_write(                             \
+      gfifo_bcast_##name##_t *b, uint32_t in, const type *arr,                 \
+      uint32_t len) {                                                          \
+    uint32_t ofst = in & b->msk;                                               \
+    uint32_t l1 = b->cap - ofst < len ? b->cap - ofst : len;                   \
+    GFIFO_MEMCPY(b->buf + ofst, arr, l1 * sizeof(type));                       \
+    GFIFO_MEMCPY(b->buf, arr + l1, (len - l1) * sizeof(type));                 \
+    atomic_store_explicit(&b->i, in + len, memory_order_release);              \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Publish one element to all readers.                                \
+   *                                                                           \
+   * @return true  Element pushed.                                             \
+   * @return false Ring is full for the slowest reader (GFIFO_BCAST_BLOCK).    \
+   */                                                                          \
+  static inline bool gfifo_bcast_##name##_push(gfifo_bcast_##name##_t *b,      \
+                                               const type *e) {                \
+    uint32_t in = atomic_load_explicit(&b->i, memory_order_relaxed);           \
+    if (__gfifo_bcast_##name##_space(b, in, 1) < 1) {                          \
+      return false;                                                            \
+    }                                                                          \
+    b->buf[in & b->msk] = *e;                                                  \
+    atomic_store_explicit(&b->i, in + 1, memory_order_release);                \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Publish len elements to all readers, all or nothing.               \
+   *                                                                           \
+   * @return true  Elements pushed.                                            \
+   * @return false Not enough room for the slowest reader, or len exceeds      \
+   *               the capacity.                                               \
+   */                                                                          \
+  static inline bool gfifo_bcast_##name##_push_array(                          \
+      gfifo_bcast_##name##_t *b, const type *arr, uint32_t len) {              \
+    uint32_t in = atomic_load_explicit(&b->i, memory_order_relaxed);           \
+    if (len > b->cap || __gfifo_bcast_##name##_space(b, in, len) < len) {      \
+      return false;                                                            \
+    }                                                                          \
+    __gfifo_bcast_##name##_write(b, in, arr, len);                             \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Publish up to len elements to all readers.                         \
+   *                                                                           \
+   * @return Number of elements pushed.                                        \
+   */                                                                          \
+  static inline uint32_t gfifo_bcast_##name##_push_some(                       \
+      gfifo_bcast_##name##_t *b, const type *arr, uint32_t len) {              \
+    uint32_t in = atomic_load_explicit(&b->i, memory_order_relaxed);           \
+    uint32_t want = len < b->cap ? len : b->cap;                               \
+    uint32_t n = __gfifo_bcast_##name##_space(b, in, want);                    \
+    if (n > len) {                                                             \
+      n = len;                                                                 \
+    }                                                                          \
+    if (n > 0) {                                                               \
+      __gfifo_bcast_##name##_write(b, in, arr, n);                             \
+    }                                                                          \
+    return n;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Check whether reader k is attached.                                \
+   *                                                                           \
+   * @return false The producer detached the reader (GFIFO_BCAST_DETACH) or    \
+   *               it called detach().                                         \
+   */                                                                          \
+  static inline bool gfifo_bcast_##name##_is_attached(                         \
+      const gfifo_bcast_##name##_t *b, uint32_t k) {                           \
+    return atomic_load_explicit(&b->rd[k].live, memory_order_relaxed) != 0;    \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Attach reader k at the newest element.                             \
+   *                                                                           \
+   * Elements pushed before the call are not seen by the reader.               \
+   */                                                                          \
+  static inline void gfifo_bcast_##name##_attach(gfifo_bcast_##name##_t *b,    \
+                                                 uint32_t k) {                 \
+    __gfifo_bcast_##name##_reader_t *rd = &b->rd[k];                           \
+    uint32_t in = atomic_load_explicit(&b->i, memory_order_acquire);           \
+    atomic_store_explicit(&rd->o, in, memory_order_relaxed);                   \
+    atomic_store_explicit(&rd->live, 1, memory_order_release);                 \
+    atomic_thread_fence(memory_order_seq_cst);                                 \
+    in = atomic_load_explicit(&b->i, memory_order_acquire);                    \
+    atomic_store_explicit(&rd->o, in, memory_order_release);                   \
+    rd->ic = in;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Detach reader k, so it no longer holds the producer back.          \
+   */                                                                          \
+  static inline void gfifo_bcast_##name##_detach(gfifo_bcast_##name##_t *b,    \
+                                                 uint32_t k) {                 \
+    atomic_store_explicit(&b->rd[k].live, 0, memory_order_release);            \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Number of elements reader k has not read yet.                      \
+   *                                                                           \
+   * @return Unread elements, 0 if the reader is detached.                     \
+   */                                                                          \
+  static inline uint32_t gfifo_bcast_##name##_count(                           \
+      const gfifo_bcast_##name##_t *b, uint32_t k) {                           \
+    if (!gfifo_bcast_##name##_is_attached(b, k)) {                             \
+      return 0;                                                                \
+    }                                                                          \
+    return atomic_load_explicit(&b->i, memory_order_acquire) -                 \
+           atomic_load_explicit(&b->rd[k].o, memory_order_relaxed);            \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Read up to len elements as reader k.                               \
+   *                                                                           \
+   * @param b Ring instance.                                                   \
+   * @param k Reader index.                                                    \
+   * @param arr Destination array.                                             \
+   * @param len Maximum number of elements to read.                            \
+   *                                                                           \
+   * @return Number of elements read, 0 if none are available or the reader    \
+   *         is detached (arr contents are then undefined).                    \
+   */                                                                          \
+  static inline uint32_t gfifo_bcast_##name##_pop_some(                        \
+      gfifo_bcast_##name##_t *b, uint32_t k, type *arr, uint32_t len) {        \
+    __gfifo_bcast_##name##_reader_t *rd = &b->rd[k];                           \
+    if (!atomic_load_explicit(&rd->live, memory_order_relaxed)) {              \
+      return 0;                                                                \
+    }                                                                          \
+    uint32_t out = atomic_load_explicit(&rd->o, memory_order_relaxed);         \
+    uint32_t n = rd->ic - out;                                                 \
+    if (n < len) {                                                             \
+      rd->ic = atomic_load_explicit(&b->i, memory_order_acquire);              \
+      n = rd->ic - out;                                                        \
+    }                                                                          \
+    if (n > len) {                                                             \
+      n = len;                                                                 \
+    }                                                                          \
+    if (n == 0) {                                                              \
+      return 0;                                                                \
+    }                                                                          \
+    uint32_t ofst = out & b->msk;                                              \
+    uint32_t l1 = b->cap - ofst < n ? b->cap - ofst : n;                       \
+    GFIFO_MEMCPY(arr, b->buf + ofst, l1 * sizeof(type));                       \
+    GFIFO_MEMCPY(arr + l1, b->buf, (n - l1) * sizeof(type));                   \
+    atomic_thread_fence(memory_order_acquire);                                 \
+    if (!atomic_load_explicit(&rd->live, memory_order_relaxed)) {              \
+      return 0;                                                                \
+    }                                                                          \
+    atomic_store_explicit(&rd->o, out + n, memory_order_release);              \
+    return n;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Read one element as reader k.                                      \
+   *                                                                           \
+   * @return true  Element read.                                               \
+   * @return false No element available, or the reader is detached.            \
+   */                                                                          \
+  static inline bool gfifo_bcast_##name##_pop(gfifo_bcast_##name##_t *b,       \
+                                              uint32_t k, type *e) {           \
+    return gfifo_bcast_##name##_pop_some(b, k, e, 1) == 1;                     \
+  }
+
+#endif // GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_BCAST_H__
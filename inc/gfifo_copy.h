@@ -0,0 +1,161 @@
+/**
+ * @file gfifo_copy.h
+ * @brief Bulk copy kernels for GFIFO_MEMCPY.
+ *
+ * @details
+ * gfifo_copy() has memcpy() semantics. Copies below GFIFO_COPY_NT_THRESHOLD
+ * bytes go to memcpy(); larger ones use non-temporal stores so a burst the
+ * other core reads exactly once does not evict the writer's working set:
+ *   - x86-64: AVX2 (selected at run time via __builtin_cpu_supports(), or
+ *     unconditionally when built with -mavx2), otherwise SSE2;
+ *   - AArch64: NEON loads with STNP stores;
+ *   - anything else: memcpy().
+ *
+ * Usage (the hook must be defined before gfifo.h is included):
+ *   #include "gfifo_copy.h"
+ *   #define GFIFO_MEMCPY(dst, src, n) gfifo_copy((dst), (src), (n))
+ *   #include "gfifo.h"
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_COPY_H__
+#define __GFIFO_COPY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Copy size in bytes from which non-temporal kernels are used.
+ *
+ * Should be well above the L1 size; below it the data is usually still
+ * cache resident when the consumer reads it.
+ */
+#ifndef GFIFO_COPY_NT_THRESHOLD
+#define GFIFO_COPY_NT_THRESHOLD (256u * 1024u)
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define __GFIFO_COPY_X86 1
+
+/* Copy the unaligned head with memcpy() so all streaming stores are aligned
+ * to `a` bytes; returns the number of head bytes. */
+static inline size_t __gfifo_copy_head(uint8_t *d, const uint8_t *s, size_t n,
+                                       size_t a) {
+  size_t h = (a - ((uintptr_t)d & (a - 1))) & (a - 1);
+  if (h > n) {
+    h = n;
+  }
+  memcpy(d, s, h);
+  return h;
+}
+
+static inline void __gfifo_copy_nt_sse2(uint8_t *d, const uint8_t *s,
+                                        size_t n) {
+  size_t k = __gfifo_copy_head(d, s, n, 16);
+  for (; k + 64 <= n; k += 64) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(s + k));
+    __m128i b = _mm_loadu_si128((const __m128i *)(s + k + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *)(s + k + 32));
+    __m128i e = _mm_loadu_si128((const __m128i *)(s + k + 48));
+    _mm_stream_si128((__m128i *)(d + k), a);
+    _mm_stream_si128((__m128i *)(d + k + 16), b);
+    _mm_stream_si128((__m128i *)(d + k + 32), c);
+    _mm_stream_si128((__m128i *)(d + k + 48), e);
+  }
+  memcpy(d + k, s + k, n - k);
+  _mm_sfence();
+}
+
+__attribute__((target("avx2"))) static inline void
+__gfifo_copy_nt_avx2(uint8_t *d, const uint8_t *s, size_t n) {
+  size_t k = __gfifo_copy_head(d, s, n, 32);
+  for (; k + 128 <= n; k += 128) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)(s + k));
+    __m256i b = _mm256_loadu_si256((const __m256i *)(s + k + 32));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(s + k + 64));
+    __m256i e = _mm256_loadu_si256((const __m256i *)(s + k + 96));
+    _mm256_stream_si256((__m256i *)(d + k), a);
+    _mm256_stream_si256((__m256i *)(d + k + 32), b);
+    _mm256_stream_si256((__m256i *)(d + k + 64), c);
+    _mm256_stream_si256((__m256i *)(d + k + 96), e);
+  }
+  memcpy(d + k, s + k, n - k);
+  _mm_sfence();
+}
+
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#include <arm_neon.h>
+#define __GFIFO_COPY_NEON 1
+
+static inline void __gfifo_copy_nt_neon(uint8_t *d, const uint8_t *s,
+                                        size_t n) {
+  size_t k = 0;
+  for (; k + 64 <= n; k += 64) {
+    uint8x16_t a = vld1q_u8(s + k);
+    uint8x16_t b = vld1q_u8(s + k + 16);
+    uint8x16_t c = vld1q_u8(s + k + 32);
+    uint8x16_t e = vld1q_u8(s + k + 48);
+    __asm__ volatile("stnp %q0, %q1, [%4]\n\t"
+                     "stnp %q2, %q3, [%4, #32]"
+                     :
+                     : "w"(a), "w"(b), "w"(c), "w"(e), "r"(d + k)
+                     : "memory");
+  }
+  memcpy(d + k, s + k, n - k);
+}
+#endif
+
+/**
+ * @brief Name of the kernel gfifo_copy() uses for large copies.
+ *
+ * @return "avx2-nt", "sse2-nt", "neon-nt" or "memcpy".
+ */
+static inline const char *gfifo_copy_backend(void) {
+#if defined(__GFIFO_COPY_X86)
+#if defined(__AVX2__)
+  return "avx2-nt";
+#else
+  return __builtin_cpu_supports("avx2") ? "avx2-nt" : "sse2-nt";
+#endif
+#elif defined(__GFIFO_COPY_NEON)
+  return "neon-nt";
+#else
+  return "memcpy";
+#endif
+}
+
+/**
+ * @brief memcpy() replacement using non-temporal stores for large copies.
+ *
+ * @param dst Destination, must not overlap src.
+ * @param src Source.
+ * @param n Number of bytes.
+ *
+ * @return dst.
+ */
+static inline void *gfifo_copy(void *dst, const void *src, size_t n) {
+  if (n < GFIFO_COPY_NT_THRESHOLD) {
+    return memcpy(dst, src, n);
+  }
+#if defined(__GFIFO_COPY_X86)
+#if defined(__AVX2__)
+  __gfifo_copy_nt_avx2((uint8_t *)dst, (const uint8_t *)src, n);
+#else
+  if (__builtin_cpu_supports("avx2")) {
+    __gfifo_copy_nt_avx2((uint8_t *)dst, (const uint8_t *)src, n);
+  } else {
+    __gfifo_copy_nt_sse2((uint8_t *)dst, (const uint8_t *)src, n);
+  }
+#endif
+#elif defined(__GFIFO_COPY_NEON)
+  __gfifo_copy_nt_neon((uint8_t *)dst, (const uint8_t *)src, n);
+#else
+  memcpy(dst, src, n);
+#endif
+  return dst;
+}
+
+#endif //! __GFIFO_COPY_H__
@@ -0,0 +1,294 @@
+/**
+ * @file gfifo_elastic.h
+ * @brief Growable SPSC FIFO made of linked gfifo segments.
+ *
+ * @details
+ * An elastic FIFO starts with a small segment (an ordinary atomic gfifo)
+ * and grows by handing off to a new, larger one instead of reallocating:
+ *   - when push/push_array do not fit in the producer's segment, the
+ *     producer allocates a segment of twice the capacity (up to max_cap),
+ *     pushes into it and links it after the current one with a release
+ *     store of next;
+ *   - the consumer keeps popping from its segment; only once it is empty
+ *     does it look at next (acquire), re-check the old segment for
+ *     elements pushed before the link, free it and move on.
+ * Neither side ever waits for the other, and FIFO order is kept across
+ * segments. While old segments drain, the memory in use stays below twice
+ * max_cap.
+ *
+ * shrink() is the reverse handoff: called by the producer while the FIFO
+ * is idle, it links a new segment of min_cap elements, and the consumer
+ * frees the large one when it passes it.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC_CL(msg, struct msg);
+ *   DECLARE_GFIFO_ELASTIC_TYPE(msg, msg, struct msg);
+ *   gfifo_elastic_msg_t q;
+ *   gfifo_elastic_msg_init(&q, 64, 65536);
+ *   gfifo_elastic_msg_push_array(&q, msgs, n);          // producer thread
+ *   n = gfifo_elastic_msg_pop_some(&q, out, 32);        // consumer thread
+ *   gfifo_elastic_msg_destroy(&q);
+ *
+ * Requires C11 <stdatomic.h> and aligned_alloc() (or GFIFO_ELASTIC_ALLOC).
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_ELASTIC_H__
+#define __GFIFO_ELASTIC_H__
+
+#include "gfifo.h"
+
+#ifdef GFIFO_HAS_ATOMICS
+
+#include <stdlib.h>
+
+/**
+ * @brief Segment allocator hooks.
+ *
+ * GFIFO_ELASTIC_ALLOC(n) must return n bytes aligned to GFIFO_CACHELINE, n
+ * being a multiple of GFIFO_CACHELINE. Segments are freed by the consumer
+ * thread. Override both before including this header, e.g. with a memory
+ * pool on targets without aligned_alloc().
+ */
+#ifndef GFIFO_ELASTIC_ALLOC
+#define GFIFO_ELASTIC_ALLOC(n) aligned_alloc(GFIFO_CACHELINE, (n))
+#endif
+#ifndef GFIFO_ELASTIC_FREE
+#define GFIFO_ELASTIC_FREE(p) free(p)
+#endif
+
+/**
+ * @brief  Declare an elastic FIFO type over an existing gfifo type.
+ *
+ * @param name  Suffix used to form the elastic FIFO type name.
+ * @param fifo  Name of a gfifo type declared with DECLARE_GFIFO_TYPE_ATOMIC()
+ *              or DECLARE_GFIFO_TYPE_ATOMIC_CL().
+ * @param type  Element type of that FIFO type.
+ *
+ * The generated type is:
+ *     gfifo_elastic_<name>_t
+ *
+ * push/push_array/shrink/capacity must only be called by the producer,
+ * pop/pop_some/is_empty only by the consumer.
+ */
+#define DECLARE_GFIFO_ELASTIC_TYPE(name, fifo, type)                           \
+  typedef struct __gfifo_elastic_##name##_seg {                                \
+    gfifo_##fifo##_t f;                                                        \
+    _Atomic(struct __gfifo_elastic_##name##_seg *) next;                       \
+  } __gfifo_elastic_##name##_seg_t;                                            \
+                                                                               \
+  typedef struct {                                                             \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) __gfifo_elastic_##name##_seg_t *tail;     \
+    uint32_t min_cap;                                                          \
+    uint32_t max_cap;                                                          \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) __gfifo_elastic_##name##_seg_t *head;     \
+  } gfifo_elastic_##name##_t;                                                  \
+                                                                               \
+  /* Allocate a segment of cap elements, with its storage right after it. */   \
+  static inline __gfifo_elastic_##name##_seg_t *                               \
+      __gfifo_elastic_##name##_seg_new(uint32_t cap) {                         \
+    size_t hdr = (sizeof(__gfifo_elastic_##name##_seg_t) +                     \
+                  GFIFO_CACHELINE - 1) & ~(size_t)(GFIFO_CACHELINE - 1);       \
+    size_t len = (hdr + (size_t)cap * sizeof(type) + GFIFO_CACHELINE - 1) &    \
+                 ~(size_t)(GFIFO_CACHELINE - 1);                               \
+    __gfifo_elastic_##name##_seg_t *s =                                        \
+        (__gfifo_elastic_##name##_seg_t *)GFIFO_ELASTIC_ALLOC(len);            \
+    if (s == NULL) {                                                           \
+      return NULL;                                                             \
+    }                                                                          \
+    gfifo_##fifo##_init(&s->f, (type *)((uint8_t *)s + hdr), cap);             \
+    atomic_init(&s->next, NULL);                                               \
+    return s;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Initialize elastic FIFO with a first segment of min_cap elements.  \
+   *                                                                           \
+   * @param q FIFO instance.                                                   \
+   * @param min_cap Initial capacity and shrink target, a power of two.        \
+   * @param max_cap Largest segment capacity, a power of two >= min_cap and    \
+   *                <= 2^31.                                                   \
+   *                                                                           \
+   * @return true  Initialization succeeded.                                   \
+   * @return false Invalid capacities or out of memory.                        \
+   */                                                                          \
+  static inline bool gfifo_elastic_##name##_init(gfifo_elastic_##name##_t *q,  \
+                                                 uint32_t min_cap,             \
+                                                 uint32_t max_cap) {           \
+    if (min_cap == 0 || (min_cap & (min_cap - 1)) != 0 ||                      \
+        (max_cap & (max_cap - 1)) != 0 || max_cap < min_cap ||                 \
+        max_cap > (1u << 31)) {                                                \
+      return false;                                                            \
+    }                                                                          \
+    q->tail = __gfifo_elastic_##name##_seg_new(min_cap);                       \
+    if (q->tail == NULL) {                                                     \
+      return false;                                                            \
+    }                                                                          \
+    q->head = q->tail;                                                         \
+    q->min_cap = min_cap;                                                      \
+    q->max_cap = max_cap;                                                      \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Free all segments.                                                 \
+   *                                                                           \
+   * Must not be called while other threads access the FIFO.                   \
+   */                                                                          \
+  static inline void gfifo_elastic_##name##_destroy(                           \
+      gfifo_elastic_##name##_t *q) {                                           \
+    __gfifo_elastic_##name##_seg_t *s = q->head;                               \
+    while (s != NULL) {                                                        \
+      __gfifo_elastic_##name##_seg_t *nx =                                     \
+          atomic_load_explicit(&s->next, memory_order_relaxed);                \
+      GFIFO_ELASTIC_FREE(s);                                                   \
+      s = nx;                                                                  \
+    }                                                                          \
+    q->head = q->tail = NULL;                                                  \
+  }                                                                            \
+                                                                               \
+  /* Producer: hand off to a new segment of cap elements. */                   \
+  static inline bool __gfifo_elastic_##name##_link(                            \
+      gfifo_elastic_##name##_t *q, uint32_t cap, const type *arr,              \
+      uint32_t len) {                                                          \
+    __gfifo_elastic_##name##_seg_t *s =                                        \
+        __gfifo_elastic_##name##_seg_new(cap);                                 \
+    if (s == NULL) {                                                           \
+      return false;                                                            \
+    }                                                                          \
+    if (len > 0) {                                                             \
+      gfifo_##fifo##_push_array(&s->f, arr, len);                              \
+    }                                                                          \
+    atomic_store_explicit(&q->tail->next, s, memory_order_release);            \
+    q->tail = s;                                                               \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /* Producer: grow into a segment large enough for len more elements. */      \
+  static inline bool __gfifo_elastic_##name##_grow(                            \
+      gfifo_elastic_##name##_t *q, const type *arr, uint32_t len) {            \
+    uint32_t cap = q->tail->f.cap;                                             \
+    if (len > q->max_cap) {                                                    \
+      return false;                                                            \
+    }                                                                          \
+    do {                                                                       \
+      if (cap >= q->max_cap) {                                                 \
+        return false;                                                          \
+      }                                                                        \
+      cap *= 2;                                                                \
+    } while (cap < len);                                                       \
+    return __gfifo_elastic_##name##_link(q, cap, arr, len);                    \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push one element, growing the FIFO if it is full.                  \
+   *                                                                           \
+   * @return true  Element pushed.                                             \
+   * @return false Full at max_cap, or out of memory.                          \
+   */                                                                          \
+  static inline bool gfifo_elastic_##name##_push(gfifo_elastic_##name##_t *q,  \
+                                                 const type *e) {              \
+    return gfifo_##fifo##_push(&q->tail->f, e) ||                              \
+           __gfifo_elastic_##name##_grow(q, e, 1);                             \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push len elements, all or nothing, growing the FIFO if needed.     \
+   *                                                                           \
+   * @return true  Elements pushed.                                            \
+   * @return false Full at max_cap, len > max_cap, or out of memory.           \
+   */                                                                          \
+  static inline bool gfifo_elastic_##name##_push_array(                        \
+      gfifo_elastic_##name##_t *q, const type *arr, uint32_t len) {            \
+    return gfifo_##fifo##_push_array(&q->tail->f, arr, len) ||                 \
+           __gfifo_elastic_##name##_grow(q, arr, len);                         \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Shrink back to min_cap if the FIFO is idle.                        \
+   *                                                                           \
+   * Call from the producer's idle path. Does nothing unless the producer's    \
+   * segment is empty and larger than min_cap.                                 \
+   *                                                                           \
+   * @return true  Handed off to a segment of min_cap elements.                \
+   * @return false FIFO not empty, already at min_cap, or out of memory.       \
+   */                                                                          \
+  static inline bool gfifo_elastic_##name##_shrink(                            \
+      gfifo_elastic_##name##_t *q) {                                           \
+    if (q->tail->f.cap <= q->min_cap ||                                        \
+        !gfifo_##fifo##_is_empty(&q->tail->f)) {                               \
+      return false;                                                            \
+    }                                                                          \
+    return __gfifo_elastic_##name##_link(q, q->min_cap, NULL, 0);              \
+  }                                                                            \
+                                                                               \
+  /** @brief Capacity of the producer's current segment. */                    \
+  static inline uint32_t gfifo_elastic_##name##_capacity(                      \
+      const gfifo_elastic_##name##_t *q) {                                     \
+    return q->tail->f.cap;                                                     \
+  }                                                                            \
+                                                                               \
+  /* Consumer: move past an empty segment if the producer linked a newer one.  \
+   * Yields false if there is none. */                                         \
+  static inline bool __gfifo_elastic_##name##_next(                            \
+      gfifo_elastic_##name##_t *q) {                                           \
+    __gfifo_elastic_##name##_seg_t *s = q->head;                               \
+    __gfifo_elastic_##name##_seg_t *nx =                                       \
+        atomic_load_explicit(&s->next, memory_order_acquire);                  \
+    if (nx == NULL || !gfifo_##fifo##_is_empty(&s->f)) {                       \
+      return nx != NULL;                                                       \
+    }                                                                          \
+    q->head = nx;                                                              \
+    GFIFO_ELASTIC_FREE(s);                                                     \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop one element.                                                   \
+   *                                                                           \
+   * @return true  Element popped.                                             \
+   * @return false FIFO is empty.                                              \
+   */                                                                          \
+  static inline bool gfifo_elastic_##name##_pop(gfifo_elastic_##name##_t *q,   \
+                                                type *e) {                     \
+    do {                                                                       \
+      if (gfifo_##fifo##_pop(&q->head->f, e)) {                                \
+        return true;                                                           \
+      }                                                                        \
+    } while (__gfifo_elastic_##name##_next(q));                                \
+    return false;                                                              \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop up to len elements.                                            \
+   *                                                                           \
+   * Elements of one call come from a single segment.                          \
+   *                                                                           \
+   * @return Number of elements popped.                                        \
+   */                                                                          \
+  static inline uint32_t gfifo_elastic_##name##_pop_some(                      \
+      gfifo_elastic_##name##_t *q, type *arr, uint32_t len) {                  \
+    do {                                                                       \
+      uint32_t n = (uint32_t)gfifo_##fifo##_pop_some(&q->head->f, arr, len);   \
+      if (n > 0 || len == 0) {                                                 \
+        return n;                                                              \
+      }                                                                        \
+    } while (__gfifo_elastic_##name##_next(q));                                \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  /** @brief Check whether the FIFO is empty (consumer). */                    \
+  static inline bool gfifo_elastic_##name##_is_empty(                          \
+      gfifo_elastic_##name##_t *q) {                                           \
+    do {                                                                       \
+      if (!gfifo_##fifo##_is_empty(&q->head->f)) {                             \
+        return false;                                                          \
+      }                                                                        \
+    } while (__gfifo_elastic_##name##_next(q));                                \
+    return true;                                                               \
+  }
+
+#endif // GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_ELASTIC_H__
@@ -0,0 +1,126 @@
+/**
+ * @file gfifo_io.h
+ * @brief readv()/writev() adapters between byte gfifos and file descriptors.
+ *
+ * @details
+ * Moves data between a socket, pipe or file and a byte FIFO without a
+ * bounce buffer:
+ *   - gfifo_<name>_fill_from_fd(f, fd) readv()s straight into the one or two
+ *     free regions from push_reserve() and commits what the kernel wrote;
+ *   - gfifo_<name>_drain_to_fd(f, fd) writev()s the one or two readable
+ *     regions from readable_spans() and releases what the kernel took.
+ * One system call per direction, whatever the wrap position. A short
+ * transfer only commits (or releases) the bytes actually moved, so the
+ * indices stay consistent.
+ *
+ * Both return the number of bytes moved, like read()/write():
+ *   - > 0: bytes moved;
+ *   - 0:   end of file (fill) or nothing to write (drain);
+ *   - -1:  errno set; EAGAIN/EWOULDBLOCK for a non-blocking fd that is not
+ *          ready, ENOBUFS when fill finds the FIFO full. EINTR is retried.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC_CL(rx, uint8_t);
+ *   DECLARE_GFIFO_IO(rx);
+ *   ssize_t n = gfifo_rx_fill_from_fd(&rx_fifo, sock);   // producer side
+ *   ssize_t m = gfifo_rx_drain_to_fd(&tx_fifo, sock);    // consumer side
+ *
+ * Requires POSIX <sys/uio.h>.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_IO_H__
+#define __GFIFO_IO_H__
+
+#include "gfifo.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * @brief  Declare fd I/O helpers for a byte gfifo type with uint32_t
+ *         indices.
+ *
+ * @param name  Name of a gfifo type declared with element type uint8_t.
+ *
+ * fill_from_fd() is a producer operation, drain_to_fd() a consumer one.
+ */
+#define DECLARE_GFIFO_IO(name) DECLARE_GFIFO_IO_EX(name, uint32_t)
+
+/**
+ * @brief  DECLARE_GFIFO_IO() for a byte gfifo type with a custom index
+ *         type (see DECLARE_GFIFO_TYPE_EX()).
+ */
+#define DECLARE_GFIFO_IO_EX(name, idx_t)                                       \
+  /**                                                                          \
+   * @brief Read from fd directly into the free space of the FIFO.             \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param fd File descriptor to read from.                                   \
+   *                                                                           \
+   * @return Bytes read and pushed, 0 on end of file, -1 on error.             \
+   */                                                                          \
+  static inline ssize_t gfifo_##name##_fill_from_fd(gfifo_##name##_t *f,       \
+                                                    int fd) {                  \
+    uint8_t *p1, *p2;                                                          \
+    idx_t l1, l2;                                                              \
+    struct iovec iov[2];                                                       \
+    /* ask for the free space only, so a fill is never counted as a failed     \
+     * push; it can only grow until push_reserve() looks */                    \
+    idx_t spc = (idx_t)(f->cap - gfifo_##name##_count(f));                     \
+    if (gfifo_##name##_push_reserve(f, spc, &p1, &l1, &p2, &l2) == 0) {        \
+      errno = ENOBUFS;                                                         \
+      return -1;                                                               \
+    }                                                                          \
+    iov[0].iov_base = p1;                                                      \
+    iov[0].iov_len = l1;                                                       \
+    iov[1].iov_base = p2;                                                      \
+    iov[1].iov_len = l2;                                                       \
+    ssize_t n;                                                                 \
+    do {                                                                       \
+      n = readv(fd, iov, l2 ? 2 : 1);                                          \
+    } while (n < 0 && errno == EINTR);                                         \
+    if (n > 0) {                                                               \
+      gfifo_##name##_push_commit(f, (idx_t)n);                                 \
+    }                                                                          \
+    return n;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Write the readable contents of the FIFO to fd.                     \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param fd File descriptor to write to.                                    \
+   *                                                                           \
+   * @return Bytes written and released, 0 if the FIFO is empty, -1 on         \
+   *         error.                                                            \
+   */                                                                          \
+  static inline ssize_t gfifo_##name##_drain_to_fd(gfifo_##name##_t *f,        \
+                                                   int fd) {                   \
+    const uint8_t *p1, *p2;                                                    \
+    idx_t l1, l2;                                                              \
+    struct iovec iov[2];                                                       \
+    if (gfifo_##name##_readable_spans(f, &p1, &l1, &p2, &l2) == 0) {           \
+      return 0;                                                                \
+    }                                                                          \
+    iov[0].iov_base = (void *)p1;                                              \
+    iov[0].iov_len = l1;                                                       \
+    iov[1].iov_base = (void *)p2;                                              \
+    iov[1].iov_len = l2;                                                       \
+    ssize_t n;                                                                 \
+    do {                                                                       \
+      n = writev(fd, iov, l2 ? 2 : 1);                                         \
+    } while (n < 0 && errno == EINTR);                                         \
+    if (n > 0) {                                                               \
+      gfifo_##name##_release(f, (idx_t)n);                                     \
+    }                                                                          \
+    return n;                                                                  \
+  }
+
+#endif // __unix__ || __APPLE__
+
+#endif //! __GFIFO_IO_H__
@@ -0,0 +1,262 @@
+/**
+ * @file gfifo_lanes.h
+ * @brief Multi-lane priority FIFO built from several gfifos.
+ *
+ * @details
+ * Groups k (<= 64) SPSC gfifos of the same type under one producer and one
+ * consumer, so control messages do not queue behind bulk data. Lane 0 has
+ * the highest priority. An occupancy bitmask holds one bit per lane that
+ * may be non-empty:
+ *   - push(lane, e) pushes into the lane and sets its bit (fetch_or,
+ *     release);
+ *   - pop() picks the lane with a single ctz over the mask, instead of
+ *     calling is_empty() on every lane; a lane found empty has its bit
+ *     cleared and is then re-checked, so a concurrent push is never lost.
+ *
+ * Scheduling per lane, set with set_weight():
+ *   - weight 0 (default): strict priority, the lane is served whenever it
+ *     holds data and no higher priority lane does;
+ *   - weight w > 0: the lane is served at most w elements per round. The
+ *     round ends once every non-empty weighted lane used up its credit
+ *     and the highest priority non-empty strict lane below them, if any,
+ *     got one turn (one pop or pop_some); then all credits are refilled.
+ *     This keeps lower priority lanes from starving, while a weighted lane
+ *     never waits more than one turn behind a lower priority strict lane.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC(msg, struct msg);
+ *   DECLARE_GFIFO_LANES_TYPE(msg, msg, struct msg, 4);
+ *   static struct msg storage[4 * 256];
+ *   gfifo_lanes_msg_t q;
+ *   gfifo_lanes_msg_init(&q, storage, 256);
+ *   gfifo_lanes_msg_set_weight(&q, 0, 8);
+ *   gfifo_lanes_msg_push(&q, 0, &ctrl);                // producer thread
+ *   gfifo_lanes_msg_pop(&q, &m, &lane);                // consumer thread
+ *
+ * Requires C11 <stdatomic.h>.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_LANES_H__
+#define __GFIFO_LANES_H__
+
+#include "gfifo.h"
+
+#ifdef GFIFO_HAS_ATOMICS
+
+/* Mask with the low k bits set, 1 <= k <= 64. */
+#define __GFIFO_LANES_MASK(k) (~(uint64_t)0 >> (64 - (k)))
+
+/**
+ * @brief  Declare a multi-lane FIFO type over an existing gfifo type.
+ *
+ * @param name  Suffix used to form the multi-lane FIFO type name.
+ * @param fifo  Name of a gfifo type declared with atomic indices.
+ * @param type  Element type of that FIFO type.
+ * @param k     Number of lanes, a compile-time constant in [1, 64].
+ *
+ * The generated type is:
+ *     gfifo_lanes_<name>_t
+ *
+ * push/push_array must only be called by one producer, pop/pop_some and
+ * set_weight only by one consumer.
+ */
+#define DECLARE_GFIFO_LANES_TYPE(name, fifo, type, k)                          \
+  _Static_assert((k) >= 1 && (k) <= 64, "gfifo lanes: 1 to 64 lanes");         \
+                                                                               \
+  typedef struct {                                                             \
+    gfifo_##fifo##_t lane[k];                                                  \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) _Atomic uint64_t occ;                     \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) uint64_t eligible;                        \
+    uint64_t weighted;                                                         \
+    uint32_t credit[k];                                                        \
+    uint32_t weight[k];                                                        \
+  } gfifo_lanes_##name##_t;                                                    \
+                                                                               \
+  /**                                                                          \
+   * @brief Initialize multi-lane FIFO with user_provided storage.             \
+   *                                                                           \
+   * All lanes start with strict priority (weight 0).                          \
+   *                                                                           \
+   * @param q FIFO instance.                                                   \
+   * @param buf Storage for k * size elements, lane j uses buf + j * size.     \
+   * @param size Capacity of every lane in elements, must be a power of two.   \
+   *                                                                           \
+   * @return true  Initialization succeeded.                                   \
+   * @return false Invalid size or NULL buffer.                                \
+   */                                                                          \
+  static inline bool gfifo_lanes_##name##_init(gfifo_lanes_##name##_t *q,      \
+                                               type *buf, uint32_t size) {     \
+    for (uint32_t j = 0; j < (k); j++) {                                       \
+      if (buf == NULL ||                                                       \
+          !gfifo_##fifo##_init(&q->lane[j], buf + (size_t)j * size, size)) {   \
+        return false;                                                          \
+      }                                                                        \
+      q->credit[j] = 0;                                                        \
+      q->weight[j] = 0;                                                        \
+    }                                                                          \
+    q->eligible = __GFIFO_LANES_MASK(k);                                       \
+    q->weighted = 0;                                                           \
+    atomic_store_explicit(&q->occ, 0, memory_order_release);                   \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Set the scheduling weight of a lane.                               \
+   *                                                                           \
+   * @param q FIFO instance.                                                   \
+   * @param lane Lane index.                                                   \
+   * @param w Elements served per round, 0 for strict priority.                \
+   */                                                                          \
+  static inline void gfifo_lanes_##name##_set_weight(                          \
+      gfifo_lanes_##name##_t *q, uint32_t lane, uint32_t w) {                  \
+    uint64_t bit = (uint64_t)1 << lane;                                        \
+    q->weight[lane] = w;                                                       \
+    q->credit[lane] = w;                                                       \
+    q->weighted = w ? (q->weighted | bit) : (q->weighted & ~bit);              \
+    q->eligible |= bit;                                                        \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push one element into a lane.                                      \
+   *                                                                           \
+   * @return true  Element pushed.                                             \
+   * @return false Lane is full.                                               \
+   */                                                                          \
+  static inline bool gfifo_lanes_##name##_push(                                \
+      gfifo_lanes_##name##_t *q, uint32_t lane, const type *e) {               \
+    if (!gfifo_##fifo##_push(&q->lane[lane], e)) {                             \
+      return false;                                                            \
+    }                                                                          \
+    atomic_fetch_or_explicit(&q->occ, (uint64_t)1 << lane,                     \
+                             memory_order_release);                            \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push len elements into a lane, all or nothing.                     \
+   *                                                                           \
+   * @return true  Elements pushed.                                            \
+   * @return false Not enough free space in the lane.                          \
+   */                                                                          \
+  static inline bool gfifo_lanes_##name##_push_array(                          \
+      gfifo_lanes_##name##_t *q, uint32_t lane, const type *arr,               \
+      uint32_t len) {                                                          \
+    if (!gfifo_##fifo##_push_array(&q->lane[lane], arr, len)) {                \
+      return false;                                                            \
+    }                                                                          \
+    atomic_fetch_or_explicit(&q->occ, (uint64_t)1 << lane,                     \
+                             memory_order_release);                            \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /* Lane to serve next, or k if all lanes are empty. Consumer only. */        \
+  static inline uint32_t __gfifo_lanes_##name##_pick(                          \
+      gfifo_lanes_##name##_t *q) {                                             \
+    uint64_t occ = atomic_load_explicit(&q->occ, memory_order_relaxed);        \
+    if (occ == 0) {                                                            \
+      return (k);                                                              \
+    }                                                                          \
+    uint64_t m = occ & q->eligible;                                            \
+    uint64_t low = m & (0 - m);                                                \
+    /* End the round when nothing eligible is left, or when the next lane is   \
+     * a strict one below weighted lanes that are waiting for credit: it is    \
+     * served once and the refilled lanes come next. */                        \
+    if (low == 0 || ((low & q->weighted) == 0 &&                               \
+                     (occ & q->weighted & ~q->eligible & (low - 1)) != 0)) {   \
+      for (uint64_t w = q->weighted; w != 0; w &= w - 1) {                     \
+        uint32_t j = __GFIFO_CTZ64(w);                                         \
+        q->credit[j] = q->weight[j];                                           \
+      }                                                                        \
+      q->eligible = __GFIFO_LANES_MASK(k);                                     \
+      if (m == 0) {                                                            \
+        m = occ;                                                               \
+      }                                                                        \
+    }                                                                          \
+    return __GFIFO_CTZ64(m);                                                   \
+  }                                                                            \
+                                                                               \
+  /* Account n elements served from lane j, or handle a stale occupancy        \
+   * bit if n is 0. Consumer only. */                                          \
+  static inline void __gfifo_lanes_##name##_served(                            \
+      gfifo_lanes_##name##_t *q, uint32_t j, uint32_t n) {                     \
+    uint64_t bit = (uint64_t)1 << j;                                           \
+    if (n == 0) {                                                              \
+      atomic_fetch_and_explicit(&q->occ, ~bit, memory_order_acq_rel);          \
+      if (!gfifo_##fifo##_is_empty(&q->lane[j])) {                             \
+        atomic_fetch_or_explicit(&q->occ, bit, memory_order_relaxed);          \
+      }                                                                        \
+    } else if (q->weighted & bit) {                                            \
+      if (q->credit[j] <= n) {                                                 \
+        q->credit[j] = 0;                                                      \
+        q->eligible &= ~bit;                                                   \
+      } else {                                                                 \
+        q->credit[j] -= n;                                                     \
+      }                                                                        \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop one element from the highest priority eligible lane.           \
+   *                                                                           \
+   * @param q FIFO instance.                                                   \
+   * @param e Output element.                                                  \
+   * @param lane Output lane the element came from.                            \
+   *                                                                           \
+   * @return true  Element popped.                                             \
+   * @return false All lanes are empty.                                        \
+   */                                                                          \
+  static inline bool gfifo_lanes_##name##_pop(gfifo_lanes_##name##_t *q,       \
+                                              type *e, uint32_t *lane) {       \
+    for (;;) {                                                                 \
+      uint32_t j = __gfifo_lanes_##name##_pick(q);                             \
+      if (j == (k)) {                                                          \
+        return false;                                                          \
+      }                                                                        \
+      bool ok = gfifo_##fifo##_pop(&q->lane[j], e);                            \
+      __gfifo_lanes_##name##_served(q, j, ok ? 1 : 0);                         \
+      if (ok) {                                                                \
+        *lane = j;                                                             \
+        return true;                                                           \
+      }                                                                        \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop up to len elements from the highest priority eligible lane.    \
+   *                                                                           \
+   * All elements come from one lane; a weighted lane is served at most its    \
+   * remaining credit.                                                         \
+   *                                                                           \
+   * @param q FIFO instance.                                                   \
+   * @param arr Destination array.                                             \
+   * @param len Maximum number of elements to pop.                             \
+   * @param lane Output lane the elements came from.                           \
+   *                                                                           \
+   * @return Number of elements popped, 0 if all lanes are empty.              \
+   */                                                                          \
+  static inline uint32_t gfifo_lanes_##name##_pop_some(                        \
+      gfifo_lanes_##name##_t *q, type *arr, uint32_t len, uint32_t *lane) {    \
+    while (len > 0) {                                                          \
+      uint32_t j = __gfifo_lanes_##name##_pick(q);                             \
+      if (j == (k)) {                                                          \
+        return 0;                                                              \
+      }                                                                        \
+      uint32_t lim = len;                                                      \
+      if ((q->weighted >> j) & 1 && q->credit[j] < lim) {                      \
+        lim = q->credit[j];                                                    \
+      }                                                                        \
+      uint32_t n = (uint32_t)gfifo_##fifo##_pop_some(&q->lane[j], arr, lim);   \
+      __gfifo_lanes_##name##_served(q, j, n);                                  \
+      if (n > 0) {                                                             \
+        *lane = j;                                                             \
+        return n;                                                              \
+      }                                                                        \
+    }                                                                          \
+    return 0;                                                                  \
+  }
+
+#endif // GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_LANES_H__
@@ -0,0 +1,169 @@
+/**
+ * @file gfifo_mirror.h
+ * @brief Virtual-memory mirrored ("magic ring buffer") gfifo backend.
+ *
+ * @details
+ * The storage of a mirrored FIFO is mapped twice back to back, so
+ * buf[cap + k] aliases buf[k]. Any window of up to cap elements starting at
+ * any position is then contiguous in virtual memory:
+ *   - push_array/pop_array/push_some/pop_some always do a single memcpy;
+ *   - push_reserve/readable_spans always return a single region (l2 == 0),
+ *     so a parser never sees a record straddling the end of buf.
+ *
+ * The mirror layout is the cache-line separated layout of
+ * DECLARE_GFIFO_TYPE_CL() with the wrap split compiled out; the generated
+ * API is the one of gfifo.h plus init_mirrored/destroy_mirrored.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC_MIRRORED(bytes, uint8_t);
+ *   gfifo_bytes_t f;
+ *   gfifo_bytes_init_mirrored(&f, 1u << 16);
+ *   ...
+ *   gfifo_bytes_destroy_mirrored(&f);
+ *
+ * Requires Linux (memfd_create + mmap). The buffer size in bytes must be a
+ * multiple of the page size. Under -std=c11, define _GNU_SOURCE or
+ * _DEFAULT_SOURCE before the first #include for syscall() and ftruncate().
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_MIRROR_H__
+#define __GFIFO_MIRROR_H__
+
+#include "gfifo.h"
+
+#if defined(__linux__)
+
+#include <linux/memfd.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * MIRROR layout: CL struct and index caching, every window of up to cap
+ * elements is contiguous. The all-ones run length (rather than cap) lets
+ * the compiler fold min(len, l2e) to len and drop the second memcpy
+ * entirely.
+ */
+#define __GFIFO_STRUCT_MIRROR(name, type, idx_t, mode)                         \
+  __GFIFO_STRUCT_CL(name, type, idx_t, mode)
+#define __GFIFO_SET_BUF_MIRROR(f, b) __GFIFO_SET_BUF_CL(f, b)
+#define __GFIFO_CACHE_RESET_MIRROR(f) __GFIFO_CACHE_RESET_CL(f)
+#define __GFIFO_PROD_OUT_MIRROR(mode, idx_t, f, in, need)                      \
+  __GFIFO_PROD_OUT_CL(mode, idx_t, f, in, need)
+#define __GFIFO_CONS_IN_MIRROR(mode, idx_t, f, out, need)                      \
+  __GFIFO_CONS_IN_CL(mode, idx_t, f, out, need)
+#define __GFIFO_L2E_MIRROR(idx_t, f, ofst) ((idx_t) ~(idx_t)0)
+
+/**
+ * @brief Map `bytes` of anonymous shared memory twice back to back.
+ *
+ * @param bytes Size of one copy, must be a non-zero multiple of the page
+ *              size.
+ *
+ * @return Base of a 2 * bytes long mapping where base[bytes + k] aliases
+ *         base[k], or NULL on failure.
+ */
+static inline void *gfifo_mirror_map(size_t bytes) {
+  long pg = sysconf(_SC_PAGESIZE);
+  if (bytes == 0 || pg <= 0 || bytes % (size_t)pg != 0 ||
+      bytes > PTRDIFF_MAX / 2) {
+    return NULL;
+  }
+  int fd = (int)syscall(SYS_memfd_create, "gfifo", MFD_CLOEXEC);
+  if (fd < 0) {
+    return NULL;
+  }
+  uint8_t *base = MAP_FAILED;
+  if (ftruncate(fd, (off_t)bytes) == 0) {
+    base = mmap(NULL, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                0);
+  }
+  if (base != MAP_FAILED &&
+      (mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+            0) == MAP_FAILED ||
+       mmap(base + bytes, bytes, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+    munmap(base, 2 * bytes);
+    base = MAP_FAILED;
+  }
+  close(fd);
+  return (base == MAP_FAILED) ? NULL : base;
+}
+
+/**
+ * @brief Release a mapping obtained from gfifo_mirror_map().
+ *
+ * @param base  Base returned by gfifo_mirror_map(), may be NULL.
+ * @param bytes Size passed to gfifo_mirror_map().
+ */
+static inline void gfifo_mirror_unmap(void *base, size_t bytes) {
+  if (base != NULL) {
+    munmap(base, 2 * bytes);
+  }
+}
+
+/**
+ * @brief  Declare a mirrored ring FIFO type with volatile indices.
+ *
+ * Same API as DECLARE_GFIFO_TYPE_CL(), plus init_mirrored() and
+ * destroy_mirrored(). init() may still be used with a buffer the caller
+ * mapped itself (e.g. via gfifo_mirror_map()), it must be mirrored.
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ */
+#define DECLARE_GFIFO_TYPE_MIRRORED(name, type)                                \
+  __GFIFO_DECLARE(name, type, uint32_t, PLAIN, MIRROR);                        \
+  __GFIFO_MIRROR_DECLARE(name, type)
+
+#ifdef GFIFO_HAS_ATOMICS
+/**
+ * @brief  Declare a mirrored ring FIFO type with C11 atomic indices.
+ *
+ * Same ordering guarantees as DECLARE_GFIFO_TYPE_ATOMIC_CL().
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ */
+#define DECLARE_GFIFO_TYPE_ATOMIC_MIRRORED(name, type)                         \
+  __GFIFO_DECLARE(name, type, uint32_t, ATOMIC, MIRROR);                       \
+  __GFIFO_MIRROR_DECLARE(name, type)
+#endif
+
+#define __GFIFO_MIRROR_DECLARE(name, type)                                     \
+  /**                                                                          \
+   * @brief Initialize FIFO with a freshly mapped mirrored buffer.             \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param size Capacity in elements, must be a power of two and              \
+   *             size * sizeof(type) a multiple of the page size.              \
+   *                                                                           \
+   * @return true  Initialization succeeded.                                   \
+   * @return false Invalid size or the mapping failed.                         \
+   */                                                                          \
+  static inline bool gfifo_##name##_init_mirrored(gfifo_##name##_t *f,         \
+                                                  uint32_t size) {             \
+    type *buf = (type *)gfifo_mirror_map((size_t)size * sizeof(type));         \
+    if (!gfifo_##name##_init(f, buf, size)) {                                  \
+      gfifo_mirror_unmap(buf, (size_t)size * sizeof(type));                    \
+      return false;                                                            \
+    }                                                                          \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Unmap a buffer mapped by init_mirrored().                          \
+   *                                                                           \
+   * @param f FIFO instance, must not be used afterwards until re-init.        \
+   */                                                                          \
+  static inline void gfifo_##name##_destroy_mirrored(gfifo_##name##_t *f) {    \
+    gfifo_mirror_unmap(f->buf, (size_t)f->cap * sizeof(type));                 \
+    f->buf = NULL;                                                             \
+  }
+
+#endif // __linux__
+
+#endif //! __GFIFO_MIRROR_H__
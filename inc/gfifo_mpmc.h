@@ -0,0 +1,188 @@
+/**
+ * @file gfifo_mpmc.h
+ * @brief Lock-free multi-producer / multi-consumer typed ring FIFO.
+ *
+ * @details
+ * Provides a macro to declare a strongly-typed bounded MPMC queue built on
+ * the same power-of-two, monotonic-index design as gfifo.h. Every slot
+ * carries a sequence number (Vyukov bounded queue), so any number of
+ * producers and consumers can push/pop concurrently without a lock:
+ *   - a producer claims position pos with a CAS on i once slot
+ *     pos & msk has sequence pos, writes the element and publishes the slot
+ *     with sequence pos + 1;
+ *   - a consumer claims position pos with a CAS on o once the slot has
+ *     sequence pos + 1, reads the element and releases the slot for the
+ *     next lap with sequence pos + cap.
+ *
+ * Requires C11 <stdatomic.h>.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_MPMC_H__
+#define __GFIFO_MPMC_H__
+
+#include "gfifo.h"
+
+#ifdef GFIFO_HAS_ATOMICS
+
+/**
+ * @brief  Declare a lock-free MPMC ring FIFO type and its operations.
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ *
+ * The generated types are:
+ *     gfifo_<name>_slot_t   storage slot, the user provides an array of them
+ *     gfifo_<name>_t        FIFO instance
+ *
+ * push/pop are lock-free and safe for any number of producers and
+ * consumers. count/is_empty/is_full are snapshots that may be stale by the
+ * time they return.
+ */
+#define DECLARE_GFIFO_MPMC_TYPE(name, type)                                    \
+  typedef struct {                                                             \
+    _Atomic uint32_t seq;                                                      \
+    type val;                                                                  \
+  } gfifo_##name##_slot_t;                                                     \
+                                                                               \
+  typedef struct {                                                             \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) gfifo_##name##_slot_t *buf;               \
+    uint32_t cap;                                                              \
+    uint32_t msk;                                                              \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) _Atomic uint32_t i;                       \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) _Atomic uint32_t o;                       \
+  } gfifo_##name##_t;                                                          \
+                                                                               \
+  /**                                                                          \
+   * @brief Initialize FIFO with user_provided slot array.                     \
+   *                                                                           \
+   * Must not be called while other threads access the FIFO.                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param buf Slot array of size elements.                                   \
+   * @param size Number of slots, must be a power of two.                      \
+   *                                                                           \
+   * @return true  Initialization succeeded.                                   \
+   * @return false Invalid size or NULL buffer.                                \
+   */                                                                          \
+  static inline bool gfifo_##name##_init(                                      \
+      gfifo_##name##_t *f, gfifo_##name##_slot_t *buf, uint32_t size) {        \
+    if (size == 0 || (size & (size - 1)) != 0 || buf == NULL) {                \
+      return false;                                                            \
+    }                                                                          \
+    for (uint32_t k = 0; k < size; k++) {                                      \
+      atomic_store_explicit(&buf[k].seq, k, memory_order_relaxed);             \
+    }                                                                          \
+    f->buf = buf;                                                              \
+    f->cap = size;                                                             \
+    f->msk = size - 1;                                                         \
+    atomic_store_explicit(&f->i, 0, memory_order_relaxed);                     \
+    atomic_store_explicit(&f->o, 0, memory_order_release);                     \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Get number of stored elements (snapshot).                          \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @return Number of claimed but not yet consumed positions.                 \
+   */                                                                          \
+  static inline uint32_t gfifo_##name##_count(const gfifo_##name##_t *f) {     \
+    uint32_t out = atomic_load_explicit(&f->o, memory_order_acquire);          \
+    uint32_t in = atomic_load_explicit(&f->i, memory_order_acquire);           \
+    uint32_t cnt = in - out;                                                   \
+    return (cnt > f->cap) ? f->cap : cnt;                                      \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief  Check whether FIFO is empty (snapshot).                           \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   */                                                                          \
+  static inline bool gfifo_##name##_is_empty(const gfifo_##name##_t *f) {      \
+    return gfifo_##name##_count(f) == 0;                                       \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief  Check whether FIFO is full (snapshot).                            \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   */                                                                          \
+  static inline bool gfifo_##name##_is_full(const gfifo_##name##_t *f) {       \
+    return gfifo_##name##_count(f) == f->cap;                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push a single element into FIFO.                                   \
+   *                                                                           \
+   * Safe to call concurrently from any number of producers.                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param e Pointer to element to push.                                      \
+   *                                                                           \
+   * @return true  Element pushed.                                             \
+   * @return false FIFO is full.                                               \
+   */                                                                          \
+  static inline bool gfifo_##name##_push(gfifo_##name##_t *f, const type *e) { \
+    gfifo_##name##_slot_t *slot;                                               \
+    uint32_t pos = atomic_load_explicit(&f->i, memory_order_relaxed);          \
+    for (;;) {                                                                 \
+      slot = &f->buf[pos & f->msk];                                            \
+      uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);   \
+      int32_t dif = (int32_t)(seq - pos);                                      \
+      if (dif == 0) {                                                          \
+        if (atomic_compare_exchange_weak_explicit(&f->i, &pos, pos + 1,        \
+                                                  memory_order_relaxed,        \
+                                                  memory_order_relaxed)) {     \
+          break;                                                               \
+        }                                                                      \
+      } else if (dif < 0) {                                                    \
+        return false;                                                          \
+      } else {                                                                 \
+        pos = atomic_load_explicit(&f->i, memory_order_relaxed);               \
+      }                                                                        \
+    }                                                                          \
+    slot->val = *e;                                                            \
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);          \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop a single element from FIFO.                                    \
+   *                                                                           \
+   * Safe to call concurrently from any number of consumers.                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param e Pointer to output element.                                       \
+   *                                                                           \
+   * @return true  Element popped.                                             \
+   * @return false FIFO is empty.                                              \
+   */                                                                          \
+  static inline bool gfifo_##name##_pop(gfifo_##name##_t *f, type *e) {        \
+    gfifo_##name##_slot_t *slot;                                               \
+    uint32_t pos = atomic_load_explicit(&f->o, memory_order_relaxed);          \
+    for (;;) {                                                                 \
+      slot = &f->buf[pos & f->msk];                                            \
+      uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);   \
+      int32_t dif = (int32_t)(seq - (pos + 1));                                \
+      if (dif == 0) {                                                          \
+        if (atomic_compare_exchange_weak_explicit(&f->o, &pos, pos + 1,        \
+                                                  memory_order_relaxed,        \
+                                                  memory_order_relaxed)) {     \
+          break;                                                               \
+        }                                                                      \
+      } else if (dif < 0) {                                                    \
+        return false;                                                          \
+      } else {                                                                 \
+        pos = atomic_load_explicit(&f->o, memory_order_relaxed);               \
+      }                                                                        \
+    }                                                                          \
+    *e = slot->val;                                                            \
+    atomic_store_explicit(&slot->seq, pos + f->cap, memory_order_release);     \
+    return true;                                                               \
+  }
+
+#endif // GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_MPMC_H__
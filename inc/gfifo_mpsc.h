@@ -0,0 +1,258 @@
+/**
+ * @file gfifo_mpsc.h
+ * @brief Multi-producer / single-consumer typed ring FIFO with batch claim.
+ *
+ * @details
+ * Provides a macro to declare a strongly-typed MPSC FIFO for the common
+ * "N producer threads, one drain thread" topology. It keeps the gfifo
+ * layout and two-segment memcpy transfers, and adds a commit index:
+ *   - a producer claims a range of len positions on i with one successful
+ *     compare-and-swap (the free space check and the claim are a single
+ *     atomic step, so a batch costs one atomic RMW, not one per element),
+ *     copies the elements in with at most two memcpy() calls and then
+ *     publishes them by advancing c once all earlier claims are published;
+ *   - the single consumer reads c instead of i and owns o, so pop, pop_array
+ *     and pop_some are the same cheap code paths as in gfifo.h.
+ *
+ * Publication on c is in claim order: a producer that is preempted between
+ * claim and publish delays the publication (not the claims) of producers
+ * that claimed after it. The window is a single bulk copy.
+ *
+ * Requires C11 <stdatomic.h>.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_MPSC_H__
+#define __GFIFO_MPSC_H__
+
+#include "gfifo.h"
+
+#ifdef GFIFO_HAS_ATOMICS
+
+/**
+ * @brief  Declare a MPSC ring FIFO type and its operations.
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO.
+ *
+ * The generated type is:
+ *     gfifo_<name>_t
+ *
+ * push/push_array are safe for any number of concurrent producers.
+ * pop/pop_array/pop_some/drop must only be called by one consumer.
+ */
+#define DECLARE_GFIFO_MPSC_TYPE(name, type)                                    \
+  typedef struct {                                                             \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) type *buf;                                \
+    uint32_t cap;                                                              \
+    uint32_t msk;                                                              \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) _Atomic uint32_t i;                       \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) _Atomic uint32_t c;                       \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) _Atomic uint32_t o;                       \
+  } gfifo_##name##_t;                                                          \
+                                                                               \
+  /**                                                                          \
+   * @brief Initialize FIFO with user_provided buffer.                         \
+   *                                                                           \
+   * Must not be called while other threads access the FIFO.                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   *                                                                           \
+   * @return true  Initialization succeeded.                                   \
+   * @return false Invalid size or NULL buffer.                                \
+   */                                                                          \
+  static inline bool gfifo_##name##_init(gfifo_##name##_t *f, type *buf,       \
+                                         uint32_t size) {                      \
+    if (size == 0 || (size & (size - 1)) != 0 || buf == NULL) {                \
+      return false;                                                            \
+    }                                                                          \
+    f->buf = buf;                                                              \
+    f->cap = size;                                                             \
+    f->msk = size - 1;                                                         \
+    atomic_store_explicit(&f->i, 0, memory_order_relaxed);                     \
+    atomic_store_explicit(&f->c, 0, memory_order_relaxed);                     \
+    atomic_store_explicit(&f->o, 0, memory_order_release);                     \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Get number of published elements.                                  \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @return Number of elements the consumer can pop.                          \
+   */                                                                          \
+  static inline uint32_t gfifo_##name##_count(const gfifo_##name##_t *f) {     \
+    return atomic_load_explicit(&f->c, memory_order_acquire) -                 \
+           atomic_load_explicit(&f->o, memory_order_acquire);                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief  Check whether FIFO has no published elements.                     \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   */                                                                          \
+  static inline bool gfifo_##name##_is_empty(const gfifo_##name##_t *f) {      \
+    return gfifo_##name##_count(f) == 0;                                       \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief  Check whether all positions are claimed.                          \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   */                                                                          \
+  static inline bool gfifo_##name##_is_full(const gfifo_##name##_t *f) {       \
+    return (atomic_load_explicit(&f->i, memory_order_acquire) -                \
+            atomic_load_explicit(&f->o, memory_order_acquire)) == f->cap;      \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push multiple elements into FIFO.                                  \
+   *                                                                           \
+   * Claims len positions with a single successful CAS on i, copies the        \
+   * array with at most two memcpy() calls and publishes it on c. Safe to      \
+   * call concurrently from any number of producers.                           \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param arr Source array.                                                  \
+   * @param len Number of elements to push.                                    \
+   *                                                                           \
+   * @return true  All elements pushed.                                        \
+   * @return false Not enough free space.                                      \
+   */                                                                          \
+  static inline bool gfifo_##name##_push_array(                                \
+      gfifo_##name##_t *f, const type *arr, uint32_t len) {                    \
+    uint32_t cap = f->cap;                                                     \
+    uint32_t msk = f->msk;                                                     \
+    uint32_t in = atomic_load_explicit(&f->i, memory_order_relaxed);           \
+    if (len == 0) {                                                            \
+      return true;                                                             \
+    }                                                                          \
+    do {                                                                       \
+      uint32_t out = atomic_load_explicit(&f->o, memory_order_acquire);        \
+      if (len > cap - (in - out)) {                                            \
+        return false;                                                          \
+      }                                                                        \
+    } while (!atomic_compare_exchange_weak_explicit(                           \
+        &f->i, &in, in + len, memory_order_relaxed, memory_order_relaxed));    \
+    uint32_t ofst = in & msk;                                                  \
+    uint32_t l2e = cap - ofst;                                                 \
+    uint32_t l1 = (len < l2e) ? len : l2e;                                     \
+    GFIFO_MEMCPY(&f->buf[ofst], arr, l1 * sizeof(type));                       \
+    if (len > l1) {                                                            \
+      GFIFO_MEMCPY(f->buf, &arr[l1], (len - l1) * sizeof(type));               \
+    }                                                                          \
+    while (atomic_load_explicit(&f->c, memory_order_acquire) != in) {          \
+      GFIFO_CPU_RELAX();                                                       \
+    }                                                                          \
+    atomic_store_explicit(&f->c, in + len, memory_order_release);              \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push a single element into FIFO.                                   \
+   *                                                                           \
+   * Safe to call concurrently from any number of producers.                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param e Pointer to element to push.                                      \
+   *                                                                           \
+   * @return true  Element pushed.                                             \
+   * @return false FIFO is full.                                               \
+   */                                                                          \
+  static inline bool gfifo_##name##_push(gfifo_##name##_t *f, const type *e) { \
+    return gfifo_##name##_push_array(f, e, 1);                                 \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop a single element from FIFO.                                    \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param e Pointer to output element.                                       \
+   *                                                                           \
+   * @return true  Element popped.                                             \
+   * @return false FIFO is empty.                                              \
+   */                                                                          \
+  static inline bool gfifo_##name##_pop(gfifo_##name##_t *f, type *e) {        \
+    uint32_t out = atomic_load_explicit(&f->o, memory_order_relaxed);          \
+    uint32_t cnt = atomic_load_explicit(&f->c, memory_order_acquire) - out;    \
+    if (cnt > 0) {                                                             \
+      *e = f->buf[out & f->msk];                                               \
+      atomic_store_explicit(&f->o, out + 1, memory_order_release);             \
+      return true;                                                             \
+    }                                                                          \
+    return false;                                                              \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Drop one element from FIFO without returning it.                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   *                                                                           \
+   * @return true  Element dropped.                                            \
+   * @return false FIFO is empty.                                              \
+   */                                                                          \
+  static inline bool gfifo_##name##_drop(gfifo_##name##_t *f) {                \
+    uint32_t out = atomic_load_explicit(&f->o, memory_order_relaxed);          \
+    uint32_t cnt = atomic_load_explicit(&f->c, memory_order_acquire) - out;    \
+    if (cnt > 0) {                                                             \
+      atomic_store_explicit(&f->o, out + 1, memory_order_release);             \
+      return true;                                                             \
+    }                                                                          \
+    return false;                                                              \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop as many elements as available from FIFO.                       \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param arr Destination array.                                             \
+   * @param len Capacity of arr in elements.                                   \
+   *                                                                           \
+   * @return Number of elements popped.                                        \
+   */                                                                          \
+  static inline uint32_t gfifo_##name##_pop_some(gfifo_##name##_t *f,          \
+                                                 type *arr, uint32_t len) {    \
+    uint32_t out = atomic_load_explicit(&f->o, memory_order_relaxed);          \
+    uint32_t in = atomic_load_explicit(&f->c, memory_order_acquire);           \
+    uint32_t cap = f->cap;                                                     \
+    uint32_t msk = f->msk;                                                     \
+    uint32_t cnt = in - out;                                                   \
+    if (len > cnt) {                                                           \
+      len = cnt;                                                               \
+    }                                                                          \
+    if (len == 0) {                                                            \
+      return 0;                                                                \
+    }                                                                          \
+    uint32_t ofst = out & msk;                                                 \
+    uint32_t l2e = cap - ofst;                                                 \
+    uint32_t l1 = (len < l2e) ? len : l2e;                                     \
+    GFIFO_MEMCPY(arr, &f->buf[ofst], l1 * sizeof(type));                       \
+    if (len > l1) {                                                            \
+      GFIFO_MEMCPY(&arr[l1], f->buf, (len - l1) * sizeof(type));               \
+    }                                                                          \
+    atomic_store_explicit(&f->o, out + len, memory_order_release);             \
+    return len;                                                                \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop multiple elements from FIFO.                                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param arr Destination array.                                             \
+   * @param len Number of elements to pop.                                     \
+   *                                                                           \
+   * @return true  All elements popped.                                        \
+   * @return false FIFO does not contain enough elements.                      \
+   */                                                                          \
+  static inline bool gfifo_##name##_pop_array(gfifo_##name##_t *f, type *arr,  \
+                                              uint32_t len) {                  \
+    if (gfifo_##name##_count(f) < len) {                                       \
+      return false;                                                            \
+    }                                                                          \
+    return gfifo_##name##_pop_some(f, arr, len) == len;                        \
+  }
+
+#endif // GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_MPSC_H__
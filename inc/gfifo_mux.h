@@ -0,0 +1,248 @@
+/**
+ * @file gfifo_mux.h
+ * @brief Fan-in multiplexer over many SPSC gfifos with a doorbell bitmap.
+ *
+ * @details
+ * A multiplexer owns n SPSC rings, one per producer, and a shared bitmap
+ * with one "may be non-empty" bit per ring:
+ *   - producer k pushes into ring k as usual and then sets bit k with one
+ *     fetch_or (release), so a batch costs one extra atomic RMW;
+ *   - the single consumer takes a whole 64-ring word of doorbells with one
+ *     exchange (acquire) and only visits rings whose bit was set, instead
+ *     of checking is_empty() on all n rings on every loop.
+ *
+ * The consumer serves rings in round-robin order. Every visit pops up to
+ * the ring's weight (0: unlimited) elements with one pop_some(), i.e. at
+ * most two memcpy() calls; a ring left non-empty is re-queued locally for
+ * the next round without touching the shared bitmap.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC_CL(ev, struct event);
+ *   DECLARE_GFIFO_MUX_TYPE(ev, ev, struct event, 64);
+ *   static struct event storage[64 * 1024];
+ *   gfifo_mux_ev_t m;
+ *   gfifo_mux_ev_init(&m, storage, 1024);
+ *   gfifo_mux_ev_push_array(&m, producer_id, evs, n);   // producer thread
+ *   n = gfifo_mux_ev_pop_some(&m, out, 64, &from);      // consumer thread
+ *
+ * Requires C11 <stdatomic.h>.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_MUX_H__
+#define __GFIFO_MUX_H__
+
+#include "gfifo.h"
+
+#ifdef GFIFO_HAS_ATOMICS
+
+/* Number of 64-bit bitmap words for n rings. */
+#define __GFIFO_MUX_WORDS(n) (((n) + 63) / 64)
+
+/* First set bit at position >= from in words[0..nw), or UINT32_MAX. */
+static inline uint32_t __gfifo_mux_find(const uint64_t *words, uint32_t nw,
+                                        uint32_t from) {
+  uint32_t w = from / 64;
+  if (w >= nw) {
+    return UINT32_MAX;
+  }
+  uint64_t m = words[w] & (~(uint64_t)0 << (from % 64));
+  while (m == 0) {
+    if (++w == nw) {
+      return UINT32_MAX;
+    }
+    m = words[w];
+  }
+  return w * 64 + __GFIFO_CTZ64(m);
+}
+
+/**
+ * @brief  Declare a fan-in multiplexer type over an existing gfifo type.
+ *
+ * @param name  Suffix used to form the multiplexer type name.
+ * @param fifo  Name of a gfifo type declared with atomic indices
+ *              (DECLARE_GFIFO_TYPE_ATOMIC* or _SHM/_MIRRORED variants).
+ * @param type  Element type of that FIFO type.
+ * @param n     Number of rings (producers), a compile-time constant.
+ *
+ * The generated type is:
+ *     gfifo_mux_<name>_t
+ *
+ * push/push_array/push_some/notify on ring k must only be called by the
+ * producer owning ring k; pop_some/set_weight only by the consumer.
+ */
+#define DECLARE_GFIFO_MUX_TYPE(name, fifo, type, n)                            \
+  typedef struct {                                                             \
+    gfifo_##fifo##_t ring[n];                                                  \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE)                                           \
+    _Atomic uint64_t bell[__GFIFO_MUX_WORDS(n)];                               \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) uint64_t pend[__GFIFO_MUX_WORDS(n)];      \
+    uint32_t cursor;                                                           \
+    uint32_t weight[n];                                                        \
+  } gfifo_mux_##name##_t;                                                      \
+                                                                               \
+  /**                                                                          \
+   * @brief Initialize multiplexer with user_provided storage.                 \
+   *                                                                           \
+   * Must not be called while other threads access the multiplexer.            \
+   *                                                                           \
+   * @param m Multiplexer instance.                                            \
+   * @param buf Storage for n * size elements, ring k uses buf + k * size.     \
+   * @param size Capacity of every ring in elements, must be a power of two.   \
+   *                                                                           \
+   * @return true  Initialization succeeded.                                   \
+   * @return false Invalid size or NULL buffer.                                \
+   */                                                                          \
+  static inline bool gfifo_mux_##name##_init(gfifo_mux_##name##_t *m,          \
+                                             type *buf, uint32_t size) {       \
+    for (uint32_t k = 0; k < (n); k++) {                                       \
+      if (buf == NULL ||                                                       \
+          !gfifo_##fifo##_init(&m->ring[k], buf + (size_t)k * size, size)) {   \
+        return false;                                                          \
+      }                                                                        \
+      m->weight[k] = 0;                                                        \
+    }                                                                          \
+    for (uint32_t w = 0; w < __GFIFO_MUX_WORDS(n); w++) {                      \
+      m->pend[w] = 0;                                                          \
+      atomic_store_explicit(&m->bell[w], 0, memory_order_release);             \
+    }                                                                          \
+    m->cursor = 0;                                                             \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Get ring k, e.g. for push_reserve()/push_commit().                 \
+   *                                                                           \
+   * Pushes made directly on the ring must be followed by notify().            \
+   */                                                                          \
+  static inline gfifo_##fifo##_t *gfifo_mux_##name##_ring(                     \
+      gfifo_mux_##name##_t *m, uint32_t k) {                                   \
+    return &m->ring[k];                                                        \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Ring the doorbell of ring k after pushing into it.                 \
+   *                                                                           \
+   * @param m Multiplexer instance.                                            \
+   * @param k Ring index.                                                      \
+   */                                                                          \
+  static inline void gfifo_mux_##name##_notify(gfifo_mux_##name##_t *m,        \
+                                               uint32_t k) {                   \
+    atomic_fetch_or_explicit(&m->bell[k / 64], (uint64_t)1 << (k % 64),        \
+                             memory_order_release);                            \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push one element into ring k.                                      \
+   *                                                                           \
+   * @return true  Element pushed.                                             \
+   * @return false Ring k is full.                                             \
+   */                                                                          \
+  static inline bool gfifo_mux_##name##_push(gfifo_mux_##name##_t *m,          \
+                                             uint32_t k, const type *e) {      \
+    if (!gfifo_##fifo##_push(&m->ring[k], e)) {                                \
+      return false;                                                            \
+    }                                                                          \
+    gfifo_mux_##name##_notify(m, k);                                           \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push len elements into ring k, all or nothing.                     \
+   *                                                                           \
+   * @return true  Elements pushed.                                            \
+   * @return false Not enough free space in ring k.                            \
+   */                                                                          \
+  static inline bool gfifo_mux_##name##_push_array(                            \
+      gfifo_mux_##name##_t *m, uint32_t k, const type *arr, uint32_t len) {    \
+    if (!gfifo_##fifo##_push_array(&m->ring[k], arr, len)) {                   \
+      return false;                                                            \
+    }                                                                          \
+    gfifo_mux_##name##_notify(m, k);                                           \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push up to len elements into ring k.                               \
+   *                                                                           \
+   * @return Number of elements pushed.                                        \
+   */                                                                          \
+  static inline uint32_t gfifo_mux_##name##_push_some(                         \
+      gfifo_mux_##name##_t *m, uint32_t k, const type *arr, uint32_t len) {    \
+    uint32_t done = (uint32_t)gfifo_##fifo##_push_some(&m->ring[k], arr, len); \
+    if (done > 0) {                                                            \
+      gfifo_mux_##name##_notify(m, k);                                         \
+    }                                                                          \
+    return done;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Set the number of elements popped from ring k per visit.           \
+   *                                                                           \
+   * @param m Multiplexer instance.                                            \
+   * @param k Ring index.                                                      \
+   * @param w Elements per visit, 0 for as many as pop_some() asks for.        \
+   */                                                                          \
+  static inline void gfifo_mux_##name##_set_weight(gfifo_mux_##name##_t *m,    \
+                                                   uint32_t k, uint32_t w) {   \
+    m->weight[k] = w;                                                          \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop up to len elements from the next ring holding data.            \
+   *                                                                           \
+   * All elements of one call come from the same ring, in its FIFO order.      \
+   *                                                                           \
+   * @param m Multiplexer instance.                                            \
+   * @param arr Destination array.                                             \
+   * @param len Maximum number of elements to pop.                             \
+   * @param from Output index of the ring the elements came from.              \
+   *                                                                           \
+   * @return Number of elements popped, 0 if no ring holds data.               \
+   */                                                                          \
+  static inline uint32_t gfifo_mux_##name##_pop_some(                          \
+      gfifo_mux_##name##_t *m, type *arr, uint32_t len, uint32_t *from) {      \
+    bool refreshed = false;                                                    \
+    if (len == 0) {                                                            \
+      return 0;                                                                \
+    }                                                                          \
+    for (;;) {                                                                 \
+      uint32_t k =                                                             \
+          __gfifo_mux_find(m->pend, __GFIFO_MUX_WORDS(n), m->cursor);          \
+      if (k == UINT32_MAX) {                                                   \
+        if (refreshed) {                                                       \
+          return 0;                                                            \
+        }                                                                      \
+        for (uint32_t w = 0; w < __GFIFO_MUX_WORDS(n); w++) {                  \
+          _Atomic uint64_t *b = &m->bell[w];                                   \
+          if (atomic_load_explicit(b, memory_order_relaxed) != 0) {            \
+            m->pend[w] |=                                                      \
+                atomic_exchange_explicit(b, 0, memory_order_acquire);          \
+          }                                                                    \
+        }                                                                      \
+        refreshed = true;                                                      \
+        m->cursor = 0;                                                         \
+        continue;                                                              \
+      }                                                                        \
+      uint64_t bit = (uint64_t)1 << (k % 64);                                  \
+      uint32_t lim = len;                                                      \
+      if (m->weight[k] != 0 && m->weight[k] < lim) {                           \
+        lim = m->weight[k];                                                    \
+      }                                                                        \
+      uint32_t done =                                                          \
+          (uint32_t)gfifo_##fifo##_pop_some(&m->ring[k], arr, lim);            \
+      if (done < lim) {                                                        \
+        m->pend[k / 64] &= ~bit;                                               \
+      }                                                                        \
+      m->cursor = k + 1;                                                       \
+      if (done > 0) {                                                          \
+        *from = k;                                                             \
+        return done;                                                           \
+      }                                                                        \
+    }                                                                          \
+  }
+
+#endif // GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_MUX_H__
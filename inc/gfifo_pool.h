@@ -0,0 +1,208 @@
+/**
+ * @file gfifo_pool.h
+ * @brief Fixed-size object pool with a gfifo of free slot indices.
+ *
+ * @details
+ * A pool holds a slab of n objects and, right next to it, an atomic SPSC
+ * gfifo of the indices of the free objects:
+ *   - alloc() pops a free index and returns the object, free() pushes its
+ *     index back; both are O(1) and never call malloc();
+ *   - the free list stores small indices (uint32_t, or uint16_t with
+ *     DECLARE_GFIFO_POOL_EX()) instead of pointers, and the objects are
+ *     found by indexing the slab, not by following a pointer.
+ *
+ * The free list uses the publication of DECLARE_GFIFO_TYPE_ATOMIC_CL(): a
+ * producer thread allocates buffers and lends them to a consumer thread
+ * (e.g. by passing their index through a data FIFO), and the consumer
+ * gives them back with free(). Everything the consumer wrote to an object
+ * before free() is visible to the producer once alloc() returns it again.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_POOL(msg, struct msg, 256);
+ *   static gfifo_pool_msg_t pool;
+ *   gfifo_pool_msg_init(&pool);
+ *   struct msg *m = gfifo_pool_msg_alloc(&pool);          // lender thread
+ *   gfifo_pool_msg_free(&pool, m);                        // borrower thread
+ *
+ * Requires C11 <stdatomic.h>.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_POOL_H__
+#define __GFIFO_POOL_H__
+
+#include "gfifo.h"
+
+#ifdef GFIFO_HAS_ATOMICS
+
+/* Smallest power of two >= n for 1 <= n <= 2^31, as a constant expression. */
+#define __GFIFO_POOL_OR1(x) ((x) | ((x) >> 1))
+#define __GFIFO_POOL_OR2(x) (__GFIFO_POOL_OR1(x) | (__GFIFO_POOL_OR1(x) >> 2))
+#define __GFIFO_POOL_OR4(x) (__GFIFO_POOL_OR2(x) | (__GFIFO_POOL_OR2(x) >> 4))
+#define __GFIFO_POOL_OR8(x) (__GFIFO_POOL_OR4(x) | (__GFIFO_POOL_OR4(x) >> 8))
+#define __GFIFO_POOL_OR16(x)                                                   \
+  (__GFIFO_POOL_OR8(x) | (__GFIFO_POOL_OR8(x) >> 16))
+#define __GFIFO_POOL_CAP(n) (__GFIFO_POOL_OR16((uint32_t)(n) - 1u) + 1u)
+
+/**
+ * @brief  Declare a pool of n objects with uint32_t slot indices.
+ *
+ * @param name  Suffix used to form the pool type name.
+ * @param type  Object type.
+ * @param n     Number of objects, a compile-time constant in [1, 2^31].
+ */
+#define DECLARE_GFIFO_POOL(name, type, n)                                      \
+  DECLARE_GFIFO_POOL_EX(name, type, n, uint32_t)
+
+/**
+ * @brief  Declare a pool of n objects with a custom slot index type.
+ *
+ * @param name    Suffix used to form the pool type name.
+ * @param type    Object type.
+ * @param n       Number of objects, a compile-time constant in [1, 2^31].
+ * @param slot_t  Unsigned integer type of the slot indices, e.g. uint16_t
+ *                for up to 65536 objects.
+ *
+ * The generated type is:
+ *     gfifo_pool_<name>_t
+ *
+ * alloc/alloc_index/alloc_some must only be called by one thread and
+ * free/free_index/free_some only by one (other or same) thread; index/at
+ * may be called by both.
+ */
+#define DECLARE_GFIFO_POOL_EX(name, type, n, slot_t)                           \
+  _Static_assert((n) >= 1 && (uint64_t)(n) <= ((uint64_t)1 << 31),             \
+                 "gfifo pool: 1 to 2^31 objects");                             \
+  _Static_assert((uint64_t)(n) - 1 <= (slot_t)~(slot_t)0,                      \
+                 "gfifo pool: slot_t too small for n objects");                \
+                                                                               \
+  __GFIFO_DECLARE(pool_##name##_fl, slot_t, uint32_t, ATOMIC, CL)              \
+                                                                               \
+  typedef struct {                                                             \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) type obj[n];                              \
+    gfifo_pool_##name##_fl_t fl;                                               \
+    slot_t slot[__GFIFO_POOL_CAP(n)];                                          \
+  } gfifo_pool_##name##_t;                                                     \
+                                                                               \
+  /**                                                                          \
+   * @brief Initialize pool, marking all n objects free.                       \
+   *                                                                           \
+   * Must not be called while other threads access the pool.                   \
+   *                                                                           \
+   * @param p Pool instance, GFIFO_CACHELINE aligned.                          \
+   */                                                                          \
+  static inline void gfifo_pool_##name##_init(gfifo_pool_##name##_t *p) {      \
+    gfifo_pool_##name##_fl_init(&p->fl, p->slot, __GFIFO_POOL_CAP(n));         \
+    for (uint32_t k = 0; k < (n); k++) {                                       \
+      slot_t s = (slot_t)k;                                                    \
+      gfifo_pool_##name##_fl_push(&p->fl, &s);                                 \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Number of free objects.                                            \
+   *                                                                           \
+   * Exact only when both sides are idle.                                      \
+   */                                                                          \
+  static inline uint32_t gfifo_pool_##name##_available(                        \
+      const gfifo_pool_##name##_t *p) {                                        \
+    return gfifo_pool_##name##_fl_count(&p->fl);                               \
+  }                                                                            \
+                                                                               \
+  /** @brief Slot index of an object of the pool. */                           \
+  static inline slot_t gfifo_pool_##name##_index(                              \
+      const gfifo_pool_##name##_t *p, const type *e) {                         \
+    return (slot_t)(e - p->obj);                                               \
+  }                                                                            \
+                                                                               \
+  /** @brief Object at a slot index. */                                        \
+  static inline type *gfifo_pool_##name##_at(gfifo_pool_##name##_t *p,         \
+                                             slot_t s) {                       \
+    return &p->obj[s];                                                         \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Take a free object.                                                \
+   *                                                                           \
+   * @return Object, or NULL if all objects are in use.                        \
+   */                                                                          \
+  static inline type *gfifo_pool_##name##_alloc(gfifo_pool_##name##_t *p) {    \
+    slot_t s;                                                                  \
+    if (!gfifo_pool_##name##_fl_pop(&p->fl, &s)) {                             \
+      return NULL;                                                             \
+    }                                                                          \
+    return &p->obj[s];                                                         \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Take the slot index of a free object.                              \
+   *                                                                           \
+   * @return true  *s holds the index of the allocated object.                 \
+   * @return false All objects are in use.                                     \
+   */                                                                          \
+  static inline bool gfifo_pool_##name##_alloc_index(                          \
+      gfifo_pool_##name##_t *p, slot_t *s) {                                   \
+    return gfifo_pool_##name##_fl_pop(&p->fl, s);                              \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Take up to len free objects.                                       \
+   *                                                                           \
+   * @param p Pool instance.                                                   \
+   * @param s Output slot indices.                                             \
+   * @param len Maximum number of objects.                                     \
+   *                                                                           \
+   * @return Number of objects allocated.                                      \
+   */                                                                          \
+  static inline uint32_t gfifo_pool_##name##_alloc_some(                       \
+      gfifo_pool_##name##_t *p, slot_t *s, uint32_t len) {                     \
+    return gfifo_pool_##name##_fl_pop_some(&p->fl, s, len);                    \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Give an object back to the pool by slot index.                     \
+   *                                                                           \
+   * A double free is caught once it would make more than n objects free;      \
+   * earlier ones go unnoticed.                                                \
+   *                                                                           \
+   * @return true  Object freed.                                               \
+   * @return false All n objects are free already, i.e. an object was freed    \
+   *               twice.                                                      \
+   */                                                                          \
+  static inline bool gfifo_pool_##name##_free_index(gfifo_pool_##name##_t *p,  \
+                                                    slot_t s) {                \
+    /* the free list can hold more than n entries when n is not a power of     \
+     * two, so bound the number of free objects by n */                        \
+    if (gfifo_pool_##name##_fl_count(&p->fl) >= (n)) {                         \
+      return false;                                                            \
+    }                                                                          \
+    return gfifo_pool_##name##_fl_push(&p->fl, &s);                            \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Give an object back to the pool.                                   \
+   *                                                                           \
+   * @return true  Object freed.                                               \
+   * @return false All n objects are free already, see free_index().           \
+   */                                                                          \
+  static inline bool gfifo_pool_##name##_free(gfifo_pool_##name##_t *p,        \
+                                              const type *e) {                 \
+    return gfifo_pool_##name##_free_index(p, gfifo_pool_##name##_index(p, e)); \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Give len objects back to the pool by slot index.                   \
+   *                                                                           \
+   * @return Number of objects freed, less than len only on a double free.     \
+   */                                                                          \
+  static inline uint32_t gfifo_pool_##name##_free_some(                        \
+      gfifo_pool_##name##_t *p, const slot_t *s, uint32_t len) {               \
+    uint32_t room = (n) - gfifo_pool_##name##_fl_count(&p->fl);                \
+    return gfifo_pool_##name##_fl_push_some(&p->fl, s,                         \
+                                           (len < room) ? len : room);         \
+  }
+
+#endif // GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_POOL_H__
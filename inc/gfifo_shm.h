@@ -0,0 +1,236 @@
+/**
+ * @file gfifo_shm.h
+ * @brief Position-independent gfifo for inter-process shared memory.
+ *
+ * @details
+ * A shared FIFO is one self-contained block: a header (magic, version,
+ * layout sizes), the atomic SPSC indices on separate cache lines and the
+ * element storage inline behind them. The block holds no pointers, so two
+ * processes can map it at different addresses and exchange data without
+ * copies or syscalls on the data path.
+ *
+ * The generated API is the one of DECLARE_GFIFO_TYPE_ATOMIC_CL() (init()
+ * must be passed f->buf) plus:
+ *   - gfifo_<name>_shm_create(path, size): create and initialize a POSIX
+ *     shared memory object, fails if it exists;
+ *   - gfifo_<name>_shm_attach(path): map an existing one, after checking
+ *     magic, version, header size and element size;
+ *   - gfifo_<name>_shm_detach(f): unmap it.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_SHM(pkt, struct pkt);
+ *   gfifo_pkt_t *tx = gfifo_pkt_shm_create("/capture", 1u << 16); // writer
+ *   gfifo_pkt_t *rx = gfifo_pkt_shm_attach("/capture");           // reader
+ *   ...
+ *   gfifo_pkt_shm_detach(rx);
+ *   gfifo_shm_unlink("/capture");
+ *
+ * Both processes must be built with the same GFIFO_CACHELINE,
+ * GFIFO_CFG_STATS, GFIFO_CFG_LATENCY, GFIFO_LAT_STAMPS and
+ * GFIFO_LAT_SUB_BITS settings; attach() rejects a mismatching header size.
+ * Requires C11 <stdatomic.h> with lock-free 32-bit atomics and POSIX
+ * shm_open(). Under -std=c11, define _POSIX_C_SOURCE >= 200809L (or
+ * _GNU_SOURCE) before the first #include for ftruncate().
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_SHM_H__
+#define __GFIFO_SHM_H__
+
+#include "gfifo.h"
+
+#if defined(GFIFO_HAS_ATOMICS) && (defined(__unix__) || defined(__APPLE__))
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2,
+               "gfifo_shm.h needs address-free (lock-free) 32-bit atomics");
+
+/** First word of an initialized shared FIFO ("GFIF"). */
+#define GFIFO_SHM_MAGIC 0x46494647u
+
+/** Bumped whenever the shared header or layout changes incompatibly. */
+#define GFIFO_SHM_VERSION 1u
+
+/*
+ * SHM layout: CL layout with a header in front and the storage inline as a
+ * flexible array member, so the block is position independent. magic is
+ * published last (release) by create() and checked first (acquire) by
+ * attach().
+ */
+#define __GFIFO_STRUCT_SHM(name, type, idx_t, mode)                            \
+  typedef struct {                                                             \
+    __GFIFO_IDX_##mode(uint32_t) magic;                                        \
+    uint32_t version;                                                          \
+    uint32_t hdr_size;                                                         \
+    uint32_t elem_size;                                                        \
+    idx_t cap;                                                                 \
+    idx_t msk;                                                                 \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) __GFIFO_IDX_##mode(idx_t) i;              \
+    idx_t oc;                                                                  \
+    __GFIFO_STATS_PROD(mode, )                                                 \
+    __GFIFO_LAT_PROD(mode, idx_t, )                                            \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) __GFIFO_IDX_##mode(idx_t) o;              \
+    idx_t ic;                                                                  \
+    __GFIFO_STATS_CONS(mode, )                                                 \
+    __GFIFO_LAT_CONS(mode, idx_t, )                                            \
+    __GFIFO_ALIGNED(GFIFO_CACHELINE) type buf[];                               \
+  } gfifo_##name##_t
+#define __GFIFO_SET_BUF_SHM(f, b) ((void)(b))
+#define __GFIFO_CACHE_RESET_SHM(f) __GFIFO_CACHE_RESET_CL(f)
+#define __GFIFO_PROD_OUT_SHM(mode, idx_t, f, in, need)                         \
+  __GFIFO_PROD_OUT_CL(mode, idx_t, f, in, need)
+#define __GFIFO_CONS_IN_SHM(mode, idx_t, f, out, need)                         \
+  __GFIFO_CONS_IN_CL(mode, idx_t, f, out, need)
+#define __GFIFO_L2E_SHM(idx_t, f, ofst) __GFIFO_L2E_CL(idx_t, f, ofst)
+
+/**
+ * @brief Create a POSIX shared memory object and map it.
+ *
+ * @param path  Object name as for shm_open(), e.g. "/capture".
+ * @param bytes Object size.
+ *
+ * @return Base of the zero-filled mapping, NULL on failure or if the object
+ *         already exists.
+ */
+static inline void *gfifo_shm_create(const char *path, size_t bytes) {
+  int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    return NULL;
+  }
+  void *base = MAP_FAILED;
+  if (ftruncate(fd, (off_t)bytes) == 0) {
+    base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    shm_unlink(path);
+    return NULL;
+  }
+  return base;
+}
+
+/**
+ * @brief Map an existing POSIX shared memory object.
+ *
+ * @param path  Object name as for shm_open().
+ * @param bytes Output object size.
+ *
+ * @return Base of the mapping, NULL on failure.
+ */
+static inline void *gfifo_shm_attach(const char *path, size_t *bytes) {
+  struct stat st;
+  int fd = shm_open(path, O_RDWR, 0);
+  if (fd < 0) {
+    return NULL;
+  }
+  void *base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    *bytes = (size_t)st.st_size;
+    base = mmap(NULL, *bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  return (base == MAP_FAILED) ? NULL : base;
+}
+
+/**
+ * @brief Unmap a mapping from gfifo_shm_create()/gfifo_shm_attach().
+ */
+static inline void gfifo_shm_detach(void *base, size_t bytes) {
+  if (base != NULL) {
+    munmap(base, bytes);
+  }
+}
+
+/**
+ * @brief Remove a shared memory object name; mappings stay valid.
+ */
+static inline int gfifo_shm_unlink(const char *path) {
+  return shm_unlink(path);
+}
+
+/**
+ * @brief  Declare a position-independent SPSC FIFO type for shared memory.
+ *
+ * @param name  Suffix used to form the FIFO type name.
+ * @param type  Element type stored in the FIFO, must not contain pointers
+ *              that are meant to be followed by the other process.
+ */
+#define DECLARE_GFIFO_TYPE_SHM(name, type)                                     \
+  __GFIFO_DECLARE(name, type, uint32_t, ATOMIC, SHM);                          \
+  __GFIFO_SHM_DECLARE(name, type)
+
+#define __GFIFO_SHM_DECLARE(name, type)                                        \
+  /**                                                                          \
+   * @brief Create a shared memory FIFO and initialize it.                     \
+   *                                                                           \
+   * @param path Object name as for shm_open().                                \
+   * @param size Capacity in elements, must be a power of two.                 \
+   *                                                                           \
+   * @return Mapped FIFO, NULL on invalid size or failure.                     \
+   */                                                                          \
+  static inline gfifo_##name##_t *gfifo_##name##_shm_create(const char *path,  \
+                                                            uint32_t size) {   \
+    if (size == 0 || (size & (size - 1)) != 0) {                               \
+      return NULL;                                                             \
+    }                                                                          \
+    gfifo_##name##_t *f = (gfifo_##name##_t *)gfifo_shm_create(                \
+        path, sizeof(gfifo_##name##_t) + (size_t)size * sizeof(type));         \
+    if (f == NULL) {                                                           \
+      return NULL;                                                             \
+    }                                                                          \
+    gfifo_##name##_init(f, f->buf, size);                                      \
+    f->version = GFIFO_SHM_VERSION;                                            \
+    f->hdr_size = (uint32_t)sizeof(gfifo_##name##_t);                          \
+    f->elem_size = (uint32_t)sizeof(type);                                     \
+    atomic_store_explicit(&f->magic, GFIFO_SHM_MAGIC, memory_order_release);   \
+    return f;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Attach to a shared memory FIFO created by another process.         \
+   *                                                                           \
+   * @param path Object name as for shm_open().                                \
+   *                                                                           \
+   * @return Mapped FIFO, NULL if it does not exist, is not initialized yet    \
+   *         or was created with an incompatible layout.                       \
+   */                                                                          \
+  static inline gfifo_##name##_t *gfifo_##name##_shm_attach(                   \
+      const char *path) {                                                      \
+    size_t bytes = 0;                                                          \
+    gfifo_##name##_t *f = (gfifo_##name##_t *)gfifo_shm_attach(path, &bytes);  \
+    if (f == NULL) {                                                           \
+      return NULL;                                                             \
+    }                                                                          \
+    if (bytes < sizeof(gfifo_##name##_t) ||                                    \
+        atomic_load_explicit(&f->magic, memory_order_acquire) !=               \
+            GFIFO_SHM_MAGIC ||                                                 \
+        f->version != GFIFO_SHM_VERSION ||                                     \
+        f->hdr_size != sizeof(gfifo_##name##_t) ||                             \
+        f->elem_size != sizeof(type) || f->cap == 0 ||                         \
+        (f->cap & (f->cap - 1)) != 0 ||                                        \
+        (bytes - sizeof(gfifo_##name##_t)) / sizeof(type) < f->cap) {          \
+      gfifo_shm_detach(f, bytes);                                              \
+      return NULL;                                                             \
+    }                                                                          \
+    return f;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Unmap a FIFO from shm_create()/shm_attach().                       \
+   *                                                                           \
+   * @param f FIFO instance, must not be used afterwards.                      \
+   */                                                                          \
+  static inline void gfifo_##name##_shm_detach(gfifo_##name##_t *f) {          \
+    size_t bytes = (size_t)f->cap * sizeof(type);                              \
+    gfifo_shm_detach(f, sizeof(gfifo_##name##_t) + bytes);                     \
+  }
+
+#endif // GFIFO_HAS_ATOMICS && POSIX
+
+#endif //! __GFIFO_SHM_H__
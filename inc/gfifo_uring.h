@@ -0,0 +1,398 @@
+/**
+ * @file gfifo_uring.h
+ * @brief Asynchronous io_uring drain of byte gfifos to files and sockets.
+ *
+ * @details
+ * One consumer thread keeps many byte FIFOs flowing to their descriptors
+ * without blocking in write():
+ *   - gfifo_<name>_uring_drain(u, d) queues one write of the readable
+ *     spans of a FIFO, straight from buf (no pop_array() copy);
+ *   - gfifo_uring_submit(u, wait_nr) submits all queued writes with one
+ *     io_uring_enter(), optionally waiting for completions;
+ *   - gfifo_uring_reap(u) handles completions and only then advances o by
+ *     the number of bytes the kernel wrote, so the producer cannot reuse a
+ *     span that is still being written. A short write leaves the rest in
+ *     the FIFO for the next drain.
+ *
+ * Each FIFO is bound to a descriptor by a gfifo_uring_drain_t with at most
+ * one write in flight, which keeps its bytes in order. Writes use
+ * IORING_OP_WRITEV over both spans; once the FIFO buffers are registered
+ * with gfifo_uring_register_buffers(), they use IORING_OP_WRITE_FIXED
+ * instead (WRITEV cannot take registered buffers), one span per write.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC_CL(log, uint8_t);
+ *   DECLARE_GFIFO_URING(log);
+ *   gfifo_uring_t u;
+ *   gfifo_uring_drain_t d[16];
+ *   gfifo_uring_init(&u, 64);
+ *   for (k = 0; k < 16; k++)
+ *     gfifo_log_uring_attach(&d[k], &fifo[k], fd[k], 0);
+ *   for (;;) {
+ *     for (k = 0; k < 16; k++)
+ *       gfifo_log_uring_drain(&u, &d[k]);
+ *     gfifo_uring_submit(&u, 1);
+ *     gfifo_uring_reap(&u);
+ *   }
+ *
+ * Uses raw system calls, no liburing. Requires Linux >= 5.1 and C11
+ * <stdatomic.h>. Under -std=c11, define _GNU_SOURCE or _DEFAULT_SOURCE
+ * before the first #include for syscall() and MAP_POPULATE.
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_URING_H__
+#define __GFIFO_URING_H__
+
+#include "gfifo.h"
+
+#if defined(__linux__) && defined(GFIFO_HAS_ATOMICS)
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/** Maximum number of FIFO buffers gfifo_uring_register_buffers() takes. */
+#ifndef GFIFO_URING_MAX_BUFFERS
+#define GFIFO_URING_MAX_BUFFERS 64
+#endif
+
+/**
+ * @brief An io_uring instance mapped into the process.
+ */
+typedef struct {
+  int fd;
+  uint32_t sq_entries;
+  uint32_t sq_mask;
+  uint32_t cq_mask;
+  uint32_t sq_tail;   /**< Next SQE slot to fill. */
+  uint32_t to_submit; /**< Queued but not yet submitted SQEs. */
+  uint32_t inflight;  /**< Queued writes not yet reaped. */
+  _Atomic uint32_t *sq_khead;
+  _Atomic uint32_t *sq_ktail;
+  uint32_t *sq_array;
+  struct io_uring_sqe *sqes;
+  _Atomic uint32_t *cq_khead;
+  _Atomic uint32_t *cq_ktail;
+  struct io_uring_cqe *cqes;
+  void *sq_map;
+  size_t sq_map_len;
+  void *cq_map;
+  size_t cq_map_len;
+  size_t sqes_len;
+} gfifo_uring_t;
+
+/**
+ * @brief Binding of one byte FIFO to a descriptor.
+ *
+ * Set up by gfifo_<name>_uring_attach(); the other fields are owned by the
+ * drain functions.
+ */
+typedef struct {
+  void *fifo;
+  bool (*release)(void *fifo, uint32_t n);
+  uint8_t *base;     /**< FIFO buffer. */
+  uint32_t size;     /**< FIFO buffer size in bytes. */
+  int fd;            /**< Destination descriptor. */
+  int buf_index;     /**< Registered buffer index, -1 if none. */
+  int64_t offset;    /**< Next file offset, -1 for the file position. */
+  uint32_t inflight; /**< Bytes of the write in flight, 0 if idle. */
+  int error;         /**< errno of the last failed write, 0 if none. */
+  struct iovec iov[2];
+} gfifo_uring_drain_t;
+
+/**
+ * @brief Release an io_uring set up by gfifo_uring_init().
+ *
+ * Writes still in flight are cancelled by the kernel.
+ */
+static inline void gfifo_uring_exit(gfifo_uring_t *u) {
+  if (u->sqes != NULL) {
+    munmap(u->sqes, u->sqes_len);
+  }
+  if (u->cq_map != NULL && u->cq_map != u->sq_map) {
+    munmap(u->cq_map, u->cq_map_len);
+  }
+  if (u->sq_map != NULL) {
+    munmap(u->sq_map, u->sq_map_len);
+  }
+  if (u->fd >= 0) {
+    close(u->fd);
+  }
+  memset(u, 0, sizeof(*u));
+  u->fd = -1;
+}
+
+/**
+ * @brief Create an io_uring and map its rings.
+ *
+ * @param u io_uring instance.
+ * @param entries Submission queue size, rounded up to a power of two by
+ *                the kernel.
+ *
+ * @return true  io_uring ready.
+ * @return false Setup failed, errno set.
+ */
+static inline bool gfifo_uring_init(gfifo_uring_t *u, uint32_t entries) {
+  struct io_uring_params p;
+  memset(u, 0, sizeof(*u));
+  memset(&p, 0, sizeof(p));
+  u->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  if (u->fd < 0) {
+    return false;
+  }
+  u->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+  u->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (u->cq_map_len > u->sq_map_len) {
+      u->sq_map_len = u->cq_map_len;
+    }
+    u->cq_map_len = u->sq_map_len;
+  }
+  u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  void *sq = mmap(NULL, u->sq_map_len, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+  if (sq == MAP_FAILED) {
+    gfifo_uring_exit(u);
+    return false;
+  }
+  u->sq_map = sq;
+  void *cq = sq;
+  if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+    cq = mmap(NULL, u->cq_map_len, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+    if (cq == MAP_FAILED) {
+      gfifo_uring_exit(u);
+      return false;
+    }
+  }
+  u->cq_map = cq;
+  void *sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    gfifo_uring_exit(u);
+    return false;
+  }
+  u->sqes = (struct io_uring_sqe *)sqes;
+  u->sq_entries = p.sq_entries;
+  u->sq_mask = *(uint32_t *)((uint8_t *)sq + p.sq_off.ring_mask);
+  u->sq_khead = (_Atomic uint32_t *)((uint8_t *)sq + p.sq_off.head);
+  u->sq_ktail = (_Atomic uint32_t *)((uint8_t *)sq + p.sq_off.tail);
+  u->sq_array = (uint32_t *)((uint8_t *)sq + p.sq_off.array);
+  u->cq_mask = *(uint32_t *)((uint8_t *)cq + p.cq_off.ring_mask);
+  u->cq_khead = (_Atomic uint32_t *)((uint8_t *)cq + p.cq_off.head);
+  u->cq_ktail = (_Atomic uint32_t *)((uint8_t *)cq + p.cq_off.tail);
+  u->cqes = (struct io_uring_cqe *)((uint8_t *)cq + p.cq_off.cqes);
+  u->sq_tail = atomic_load_explicit(u->sq_ktail, memory_order_relaxed);
+  return true;
+}
+
+/**
+ * @brief Register the buffers of attached FIFOs for WRITE_FIXED.
+ *
+ * May be called once per io_uring, before any write is queued. The
+ * buffers must stay mapped until gfifo_uring_exit(). Not for mirrored
+ * FIFOs, whose spans extend past buf + size.
+ *
+ * @param u io_uring instance.
+ * @param d Attached drains; d[k] gets buffer index k.
+ * @param n Number of drains, at most GFIFO_URING_MAX_BUFFERS.
+ *
+ * @return true  Buffers registered.
+ * @return false Registration failed, errno set.
+ */
+static inline bool gfifo_uring_register_buffers(gfifo_uring_t *u,
+                                                gfifo_uring_drain_t *const *d,
+                                                uint32_t n) {
+  struct iovec iov[GFIFO_URING_MAX_BUFFERS];
+  if (n == 0 || n > GFIFO_URING_MAX_BUFFERS) {
+    errno = EINVAL;
+    return false;
+  }
+  for (uint32_t k = 0; k < n; k++) {
+    iov[k].iov_base = d[k]->base;
+    iov[k].iov_len = d[k]->size;
+  }
+  if (syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_BUFFERS, iov,
+              n) != 0) {
+    return false;
+  }
+  for (uint32_t k = 0; k < n; k++) {
+    d[k]->buf_index = (int)k;
+  }
+  return true;
+}
+
+/* Next free SQE, zeroed, or NULL if the submission queue is full. */
+static inline struct io_uring_sqe *__gfifo_uring_get_sqe(gfifo_uring_t *u) {
+  uint32_t head = atomic_load_explicit(u->sq_khead, memory_order_acquire);
+  if (u->sq_tail - head >= u->sq_entries) {
+    return NULL;
+  }
+  struct io_uring_sqe *sqe = &u->sqes[u->sq_tail & u->sq_mask];
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+/* Publish the SQE returned by the last __gfifo_uring_get_sqe(). */
+static inline void __gfifo_uring_queue(gfifo_uring_t *u) {
+  u->sq_array[u->sq_tail & u->sq_mask] = u->sq_tail & u->sq_mask;
+  u->sq_tail++;
+  u->to_submit++;
+  u->inflight++;
+  atomic_store_explicit(u->sq_ktail, u->sq_tail, memory_order_release);
+}
+
+/**
+ * @brief Submit all queued writes.
+ *
+ * @param u io_uring instance.
+ * @param wait_nr Number of completions to wait for, 0 to return at once;
+ *                never more than the writes in flight.
+ *
+ * @return Number of SQEs submitted, -1 on error (errno set).
+ */
+static inline int gfifo_uring_submit(gfifo_uring_t *u, uint32_t wait_nr) {
+  long n;
+  if (wait_nr > u->inflight) {
+    wait_nr = u->inflight;
+  }
+  if (u->to_submit == 0 && wait_nr == 0) {
+    return 0;
+  }
+  do {
+    n = syscall(__NR_io_uring_enter, u->fd, u->to_submit, wait_nr,
+                wait_nr ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0) {
+    return -1;
+  }
+  u->to_submit -= (uint32_t)n;
+  return (int)n;
+}
+
+/**
+ * @brief Handle all available completions.
+ *
+ * For every completed write, releases the written bytes from its FIFO and
+ * advances the drain's file offset; a failed write sets the drain's error
+ * and releases nothing. Either way the drain can queue its next write.
+ *
+ * @param u io_uring instance.
+ *
+ * @return Number of completions handled.
+ */
+static inline uint32_t gfifo_uring_reap(gfifo_uring_t *u) {
+  uint32_t head = atomic_load_explicit(u->cq_khead, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(u->cq_ktail, memory_order_acquire);
+  uint32_t n = tail - head;
+  for (; head != tail; head++) {
+    const struct io_uring_cqe *cqe = &u->cqes[head & u->cq_mask];
+    gfifo_uring_drain_t *d = (gfifo_uring_drain_t *)(uintptr_t)cqe->user_data;
+    if (cqe->res > 0) {
+      d->release(d->fifo, (uint32_t)cqe->res);
+      if (d->offset >= 0) {
+        d->offset += cqe->res;
+      }
+    } else if (cqe->res < 0) {
+      d->error = -cqe->res;
+    }
+    d->inflight = 0;
+  }
+  atomic_store_explicit(u->cq_khead, tail, memory_order_release);
+  u->inflight -= n;
+  return n;
+}
+
+/**
+ * @brief  Declare io_uring drain helpers for a byte gfifo type with
+ *         uint32_t indices.
+ *
+ * @param name  Name of a gfifo type declared with element type uint8_t.
+ *
+ * The drain side (drain, submit, reap) is the FIFO's consumer and must run
+ * on one thread.
+ */
+#define DECLARE_GFIFO_URING(name)                                              \
+  static inline bool __gfifo_##name##_uring_release(void *f, uint32_t n) {     \
+    return gfifo_##name##_release((gfifo_##name##_t *)f, n);                   \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Bind a FIFO to a destination descriptor.                           \
+   *                                                                           \
+   * @param d Drain instance.                                                  \
+   * @param f FIFO instance, initialized.                                      \
+   * @param fd Destination file or socket.                                     \
+   * @param offset File offset of the first byte, -1 to use (and advance)      \
+   *               the file position, e.g. for sockets and pipes.              \
+   */                                                                          \
+  static inline void gfifo_##name##_uring_attach(                              \
+      gfifo_uring_drain_t *d, gfifo_##name##_t *f, int fd, int64_t offset) {   \
+    memset(d, 0, sizeof(*d));                                                  \
+    d->fifo = f;                                                               \
+    d->release = __gfifo_##name##_uring_release;                               \
+    d->base = f->buf;                                                          \
+    d->size = f->cap;                                                          \
+    d->fd = fd;                                                                \
+    d->buf_index = -1;                                                         \
+    d->offset = offset;                                                        \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Queue a write of the readable spans of the FIFO.                   \
+   *                                                                           \
+   * Nothing is queued while the previous write of this drain is in flight.    \
+   * The write is sent by the next gfifo_uring_submit().                       \
+   *                                                                           \
+   * @param u io_uring instance.                                               \
+   * @param d Drain instance.                                                  \
+   *                                                                           \
+   * @return 1  Write queued.                                                  \
+   * @return 0  FIFO empty or a write is already in flight.                    \
+   * @return -1 Submission queue full (errno EBUSY).                           \
+   */                                                                          \
+  static inline int gfifo_##name##_uring_drain(gfifo_uring_t *u,               \
+                                               gfifo_uring_drain_t *d) {       \
+    const uint8_t *p1, *p2;                                                    \
+    uint32_t l1, l2;                                                           \
+    if (d->inflight != 0 ||                                                    \
+        gfifo_##name##_readable_spans((gfifo_##name##_t *)d->fifo, &p1, &l1,   \
+                                      &p2, &l2) == 0) {                        \
+      return 0;                                                                \
+    }                                                                          \
+    struct io_uring_sqe *sqe = __gfifo_uring_get_sqe(u);                       \
+    if (sqe == NULL) {                                                         \
+      errno = EBUSY;                                                           \
+      return -1;                                                               \
+    }                                                                          \
+    sqe->fd = d->fd;                                                           \
+    sqe->off = (uint64_t)d->offset;                                            \
+    sqe->user_data = (uint64_t)(uintptr_t)d;                                   \
+    if (d->buf_index >= 0) {                                                   \
+      sqe->opcode = IORING_OP_WRITE_FIXED;                                     \
+      sqe->addr = (uint64_t)(uintptr_t)p1;                                     \
+      sqe->len = l1;                                                           \
+      sqe->buf_index = (uint16_t)d->buf_index;                                 \
+      d->inflight = l1;                                                        \
+    } else {                                                                   \
+      d->iov[0].iov_base = (void *)p1;                                         \
+      d->iov[0].iov_len = l1;                                                  \
+      d->iov[1].iov_base = (void *)p2;                                         \
+      d->iov[1].iov_len = l2;                                                  \
+      sqe->opcode = IORING_OP_WRITEV;                                          \
+      sqe->addr = (uint64_t)(uintptr_t)d->iov;                                 \
+      sqe->len = l2 ? 2 : 1;                                                   \
+      d->inflight = l1 + l2;                                                   \
+    }                                                                          \
+    __gfifo_uring_queue(u);                                                    \
+    return 1;                                                                  \
+  }
+
+#endif // __linux__ && GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_URING_H__
@@ -0,0 +1,416 @@
+/**
+ * @file gfifo_wait.h
+ * @brief Blocking wrappers for SPSC gfifo types.
+ *
+ * @details
+ * Every operation in gfifo.h is non-blocking. This companion header adds
+ * push_wait/pop_wait and timeout variants on top of an already declared
+ * FIFO type. A blocked side first spins for an adaptive number of attempts
+ * and then parks on a wait queue:
+ *   - Linux futex (default on Linux),
+ *   - an eventfd (define GFIFO_WAIT_USE_EVENTFD), which also makes the
+ *     queue pollable from epoll,
+ *   - user supplied hooks (define GFIFO_WAIT_PARK/GFIFO_WAIT_WAKE/
+ *     GFIFO_WAIT_NOW_NS), e.g. mapped onto an RTOS semaphore.
+ *
+ * The opposite side only issues a wakeup when a waiter is registered; the
+ * uncontended cost of a blocking push/pop is the FIFO operation plus one
+ * fence and one load of the waiter count.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC(msg, struct msg);
+ *   DECLARE_GFIFO_WAIT(msg, struct msg);
+ *   gfifo_wait_t w;
+ *   gfifo_wait_init(&w);
+ *   gfifo_msg_push_wait(&fifo, &w, &m);        // producer thread
+ *   gfifo_msg_pop_timed(&fifo, &w, &m, 10000); // consumer, 10us timeout
+ *
+ * Requires C11 <stdatomic.h> and, for the default backends, POSIX. Under
+ * -std=c11, define _GNU_SOURCE or _DEFAULT_SOURCE before the first #include
+ * for clock_gettime() and syscall().
+ *
+ * @license MIT
+ */
+
+#ifndef __GFIFO_WAIT_H__
+#define __GFIFO_WAIT_H__
+
+#include "gfifo.h"
+
+#ifdef GFIFO_HAS_ATOMICS
+
+/**
+ * @brief Upper bound of the adaptive spin before parking.
+ */
+#ifndef GFIFO_WAIT_SPIN_MAX
+#define GFIFO_WAIT_SPIN_MAX 1024
+#endif
+
+/** Timeout value meaning "wait forever". */
+#define GFIFO_WAIT_FOREVER UINT64_MAX
+
+#if defined(GFIFO_WAIT_PARK) && defined(GFIFO_WAIT_WAKE) &&                    \
+    defined(GFIFO_WAIT_NOW_NS)
+#define __GFIFO_WAIT_BACKEND_USER 1
+#elif defined(GFIFO_WAIT_USE_EVENTFD)
+#define __GFIFO_WAIT_BACKEND_EVENTFD 1
+#include <limits.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+#elif defined(__linux__)
+#define __GFIFO_WAIT_BACKEND_FUTEX 1
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#error "gfifo_wait.h: define GFIFO_WAIT_PARK/WAKE/NOW_NS for this platform"
+#endif
+
+/**
+ * @brief Wait queue one side of a FIFO parks on.
+ *
+ * epoch is bumped on every wakeup so a waiter that registered before the
+ * wakeup never sleeps on a stale condition. spin is the adaptive spin
+ * budget and is only touched by the (single) waiting side.
+ */
+typedef struct {
+  _Atomic uint32_t epoch;
+  _Atomic uint32_t waiters;
+  uint32_t spin;
+#ifdef __GFIFO_WAIT_BACKEND_EVENTFD
+  int efd;
+#endif
+} gfifo_waitq_t;
+
+/**
+ * @brief Wait state of a FIFO: consumers wait for data, producers for space.
+ */
+typedef struct {
+  gfifo_waitq_t data;
+  gfifo_waitq_t space;
+} gfifo_wait_t;
+
+#if defined(__GFIFO_WAIT_BACKEND_FUTEX) ||                                     \
+    defined(__GFIFO_WAIT_BACKEND_EVENTFD)
+static inline uint64_t __gfifo_wait_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#else
+#define __gfifo_wait_now_ns() ((uint64_t)GFIFO_WAIT_NOW_NS())
+#endif
+
+/* Absolute deadline of a relative timeout; a deadline past UINT64_MAX is
+ * GFIFO_WAIT_FOREVER instead of wrapping into the past. */
+static inline uint64_t __gfifo_wait_deadline(uint64_t timeout_ns) {
+  if (timeout_ns == GFIFO_WAIT_FOREVER) {
+    return GFIFO_WAIT_FOREVER;
+  }
+  uint64_t now = __gfifo_wait_now_ns();
+  if (timeout_ns >= GFIFO_WAIT_FOREVER - now) {
+    return GFIFO_WAIT_FOREVER;
+  }
+  return now + timeout_ns;
+}
+
+/**
+ * @brief Park on q until its epoch differs from `epoch` or timeout expires.
+ *
+ * May return spuriously; callers re-check their condition.
+ */
+static inline void __gfifo_waitq_park(gfifo_waitq_t *q, uint32_t epoch,
+                                      uint64_t timeout_ns) {
+#if defined(__GFIFO_WAIT_BACKEND_FUTEX)
+  struct timespec ts;
+  struct timespec *tp = NULL;
+  if (timeout_ns != GFIFO_WAIT_FOREVER) {
+    ts.tv_sec = (time_t)(timeout_ns / 1000000000u);
+    ts.tv_nsec = (long)(timeout_ns % 1000000000u);
+    tp = &ts;
+  }
+  syscall(SYS_futex, (uint32_t *)&q->epoch, FUTEX_WAIT_PRIVATE, epoch, tp,
+          NULL, 0);
+#elif defined(__GFIFO_WAIT_BACKEND_EVENTFD)
+  struct pollfd pfd = {.fd = q->efd, .events = POLLIN, .revents = 0};
+  int ms = -1;
+  uint64_t v;
+  if (timeout_ns != GFIFO_WAIT_FOREVER) {
+    uint64_t t = timeout_ns / 1000000u + (timeout_ns % 1000000u != 0);
+    ms = t > INT_MAX ? INT_MAX : (int)t;
+  }
+  if (atomic_load_explicit(&q->epoch, memory_order_acquire) != epoch) {
+    return;
+  }
+  if (poll(&pfd, 1, ms) > 0) {
+    (void)!read(q->efd, &v, sizeof(v));
+  }
+#else
+  GFIFO_WAIT_PARK(q, epoch, timeout_ns);
+#endif
+}
+
+/**
+ * @brief Initialize a wait queue.
+ *
+ * @return true  Initialization succeeded.
+ * @return false The backend could not be set up (eventfd).
+ */
+static inline bool gfifo_waitq_init(gfifo_waitq_t *q) {
+  atomic_store_explicit(&q->epoch, 0, memory_order_relaxed);
+  atomic_store_explicit(&q->waiters, 0, memory_order_relaxed);
+  q->spin = GFIFO_WAIT_SPIN_MAX / 8;
+#ifdef __GFIFO_WAIT_BACKEND_EVENTFD
+  q->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  return q->efd >= 0;
+#else
+  return true;
+#endif
+}
+
+/**
+ * @brief Release resources held by a wait queue.
+ */
+static inline void gfifo_waitq_destroy(gfifo_waitq_t *q) {
+#ifdef __GFIFO_WAIT_BACKEND_EVENTFD
+  if (q->efd >= 0) {
+    close(q->efd);
+    q->efd = -1;
+  }
+#else
+  (void)q;
+#endif
+}
+
+/**
+ * @brief Wake the waiter of q, if one is registered.
+ *
+ * Must be called after the state change the waiter is waiting for has been
+ * published. Costs one fence and one load when nobody waits.
+ */
+static inline void gfifo_waitq_wake(gfifo_waitq_t *q) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&q->waiters, memory_order_relaxed) == 0) {
+    return;
+  }
+  atomic_fetch_add_explicit(&q->epoch, 1, memory_order_release);
+#if defined(__GFIFO_WAIT_BACKEND_FUTEX)
+  syscall(SYS_futex, (uint32_t *)&q->epoch, FUTEX_WAKE_PRIVATE, 1, NULL, NULL,
+          0);
+#elif defined(__GFIFO_WAIT_BACKEND_EVENTFD)
+  uint64_t one = 1;
+  (void)!write(q->efd, &one, sizeof(one));
+#else
+  GFIFO_WAIT_WAKE(q);
+#endif
+}
+
+/**
+ * @brief Register as waiter on q and return the epoch to park on.
+ *
+ * The caller must re-check its condition after this call and before
+ * parking, which closes the race with a concurrent gfifo_waitq_wake().
+ */
+static inline uint32_t __gfifo_waitq_prepare(gfifo_waitq_t *q) {
+  atomic_fetch_add_explicit(&q->waiters, 1, memory_order_seq_cst);
+  atomic_thread_fence(memory_order_seq_cst);
+  return atomic_load_explicit(&q->epoch, memory_order_acquire);
+}
+
+static inline void __gfifo_waitq_cancel(gfifo_waitq_t *q) {
+  atomic_fetch_sub_explicit(&q->waiters, 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Adapt the spin budget of q after a wait.
+ *
+ * Spinning that succeeded grows the budget, parking shrinks it.
+ */
+static inline void __gfifo_waitq_adapt(gfifo_waitq_t *q, bool spun) {
+  if (spun) {
+    q->spin = (q->spin < GFIFO_WAIT_SPIN_MAX / 2) ? q->spin * 2 + 1
+                                                    : GFIFO_WAIT_SPIN_MAX;
+  } else {
+    q->spin = (q->spin > 1) ? q->spin / 2 : 1;
+  }
+}
+
+/**
+ * @brief Initialize the wait state of a FIFO.
+ */
+static inline bool gfifo_wait_init(gfifo_wait_t *w) {
+  if (!gfifo_waitq_init(&w->data)) {
+    return false;
+  }
+  if (!gfifo_waitq_init(&w->space)) {
+    gfifo_waitq_destroy(&w->data);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Release resources held by the wait state of a FIFO.
+ */
+static inline void gfifo_wait_destroy(gfifo_wait_t *w) {
+  gfifo_waitq_destroy(&w->data);
+  gfifo_waitq_destroy(&w->space);
+}
+
+/**
+ * @brief Notify a consumer blocked in pop_wait()/pop_timed().
+ *
+ * Only needed after non-blocking producer calls (push_array, push_commit,
+ * ...); the blocking wrappers notify on their own.
+ */
+static inline void gfifo_wait_notify_data(gfifo_wait_t *w) {
+  gfifo_waitq_wake(&w->data);
+}
+
+/**
+ * @brief Notify a producer blocked in push_wait()/push_timed().
+ *
+ * Only needed after non-blocking consumer calls (pop_array, release, ...).
+ */
+static inline void gfifo_wait_notify_space(gfifo_wait_t *w) {
+  gfifo_waitq_wake(&w->space);
+}
+
+/**
+ * @brief  Declare blocking push/pop wrappers for an existing FIFO type.
+ *
+ * @param name  Suffix of a type declared with one of the SPSC
+ *              DECLARE_GFIFO_TYPE* macros.
+ * @param type  Element type of that FIFO.
+ *
+ * Generates:
+ *   - gfifo_<name>_push_timed / gfifo_<name>_push_wait
+ *   - gfifo_<name>_pop_timed  / gfifo_<name>_pop_wait
+ */
+#define DECLARE_GFIFO_WAIT(name, type)                                         \
+  /**                                                                          \
+   * @brief Push an element, blocking while FIFO is full.                      \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param w Wait state of f.                                                 \
+   * @param e Pointer to element to push.                                      \
+   * @param timeout_ns Relative timeout, GFIFO_WAIT_FOREVER to never expire.   \
+   *                                                                           \
+   * @return true  Element pushed.                                             \
+   * @return false Timeout expired while FIFO was full.                        \
+   */                                                                          \
+  static inline bool gfifo_##name##_push_timed(                                \
+      gfifo_##name##_t *f, gfifo_wait_t *w, const type *e,                     \
+      uint64_t timeout_ns) {                                                   \
+    gfifo_waitq_t *q = &w->space;                                              \
+    for (uint32_t k = 0; k <= q->spin; k++) {                                  \
+      if (gfifo_##name##_push(f, e)) {                                         \
+        if (k > 0) {                                                           \
+          __gfifo_waitq_adapt(q, true);                                        \
+        }                                                                      \
+        gfifo_waitq_wake(&w->data);                                            \
+        return true;                                                           \
+      }                                                                        \
+      GFIFO_CPU_RELAX();                                                       \
+    }                                                                          \
+    __gfifo_waitq_adapt(q, false);                                             \
+    uint64_t dl = __gfifo_wait_deadline(timeout_ns);                           \
+    for (;;) {                                                                 \
+      uint32_t epoch = __gfifo_waitq_prepare(q);                               \
+      if (gfifo_##name##_push(f, e)) {                                         \
+        __gfifo_waitq_cancel(q);                                               \
+        gfifo_waitq_wake(&w->data);                                            \
+        return true;                                                           \
+      }                                                                        \
+      uint64_t left = GFIFO_WAIT_FOREVER;                                      \
+      if (dl != GFIFO_WAIT_FOREVER) {                                          \
+        uint64_t now = __gfifo_wait_now_ns();                                  \
+        if (now >= dl) {                                                       \
+          __gfifo_waitq_cancel(q);                                             \
+          return false;                                                        \
+        }                                                                      \
+        left = dl - now;                                                       \
+      }                                                                        \
+      __gfifo_waitq_park(q, epoch, left);                                      \
+      __gfifo_waitq_cancel(q);                                                 \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push an element, blocking until there is space.                    \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param w Wait state of f.                                                 \
+   * @param e Pointer to element to push.                                      \
+   */                                                                          \
+  static inline void gfifo_##name##_push_wait(                                 \
+      gfifo_##name##_t *f, gfifo_wait_t *w, const type *e) {                   \
+    (void)gfifo_##name##_push_timed(f, w, e, GFIFO_WAIT_FOREVER);              \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop an element, blocking while FIFO is empty.                      \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param w Wait state of f.                                                 \
+   * @param e Pointer to output element.                                       \
+   * @param timeout_ns Relative timeout, GFIFO_WAIT_FOREVER to never expire.   \
+   *                                                                           \
+   * @return true  Element popped.                                             \
+   * @return false Timeout expired while FIFO was empty.                       \
+   */                                                                          \
+  static inline bool gfifo_##name##_pop_timed(gfifo_##name##_t *f,             \
+                                              gfifo_wait_t *w, type *e,        \
+                                              uint64_t timeout_ns) {           \
+    gfifo_waitq_t *q = &w->data;                                               \
+    for (uint32_t k = 0; k <= q->spin; k++) {                                  \
+      if (gfifo_##name##_pop(f, e)) {                                          \
+        if (k > 0) {                                                           \
+          __gfifo_waitq_adapt(q, true);                                        \
+        }                                                                      \
+        gfifo_waitq_wake(&w->space);                                           \
+        return true;                                                           \
+      }                                                                        \
+      GFIFO_CPU_RELAX();                                                       \
+    }                                                                          \
+    __gfifo_waitq_adapt(q, false);                                             \
+    uint64_t dl = __gfifo_wait_deadline(timeout_ns);                           \
+    for (;;) {                                                                 \
+      uint32_t epoch = __gfifo_waitq_prepare(q);                               \
+      if (gfifo_##name##_pop(f, e)) {                                          \
+        __gfifo_waitq_cancel(q);                                               \
+        gfifo_waitq_wake(&w->space);                                           \
+        return true;                                                           \
+      }                                                                        \
+      uint64_t left = GFIFO_WAIT_FOREVER;                                      \
+      if (dl != GFIFO_WAIT_FOREVER) {                                          \
+        uint64_t now = __gfifo_wait_now_ns();                                  \
+        if (now >= dl) {                                                       \
+          __gfifo_waitq_cancel(q);                                             \
+          return false;                                                        \
+        }                                                                      \
+        left = dl - now;                                                       \
+      }                                                                        \
+      __gfifo_waitq_park(q, epoch, left);                                      \
+      __gfifo_waitq_cancel(q);                                                 \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop an element, blocking until one is available.                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param w Wait state of f.                                                 \
+   * @param e Pointer to output element.                                       \
+   */                                                                          \
+  static inline void gfifo_##name##_pop_wait(gfifo_##name##_t *f,              \
+                                             gfifo_wait_t *w, type *e) {       \
+    (void)gfifo_##name##_pop_timed(f, w, e, GFIFO_WAIT_FOREVER);               \
+  }
+
+#endif // GFIFO_HAS_ATOMICS
+
+#endif //! __GFIFO_WAIT_H__
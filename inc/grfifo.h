@@ -0,0 +1,248 @@
+/**
+ * @file grfifo.h
+ * @brief Variable-length record FIFO on top of a byte gfifo.
+ *
+ * @details
+ * Stores records as a GRFIFO_HDR byte header holding the payload length,
+ * followed by the payload, padded to GRFIFO_ALIGN. A record never wraps:
+ * when it does not fit before the end of buf, the producer writes a
+ * padding marker (length GRFIFO_PAD) and places the record at buf[0]. Every
+ * payload is therefore contiguous and GRFIFO_ALIGN aligned, so parsers can
+ * work on it in place.
+ *
+ * The records live in an ordinary gfifo of uint8_t, declared with any of
+ * the DECLARE_GFIFO_TYPE* macros (use DECLARE_GRFIFO_TYPE_EX() for the
+ * *_EX ones); the memory mode and layout (including the mirrored one,
+ * which never needs padding) are the ones of that type.
+ * One push or pop is a single index update of the byte FIFO.
+ *
+ * Usage:
+ *   DECLARE_GFIFO_TYPE_ATOMIC(bytes, uint8_t);
+ *   DECLARE_GRFIFO_TYPE(frame, bytes);
+ *   static _Alignas(GRFIFO_ALIGN) uint8_t buf[4096];
+ *   grfifo_frame_t f;
+ *   grfifo_frame_init(&f, buf, sizeof(buf));
+ *   grfifo_frame_push_record(&f, data, len);
+ *
+ * @license MIT
+ */
+
+#ifndef __GRFIFO_H__
+#define __GRFIFO_H__
+
+#include "gfifo.h"
+
+/**
+ * @brief Alignment of every record header and payload, a power of two >= 4.
+ */
+#ifndef GRFIFO_ALIGN
+#define GRFIFO_ALIGN 8
+#endif
+
+/** Size of the record header; keeps the payload GRFIFO_ALIGN aligned. */
+#define GRFIFO_HDR ((uint32_t)GRFIFO_ALIGN)
+
+/** Header length value of the padding marker before a wrapped record. */
+#define GRFIFO_PAD UINT32_MAX
+
+/** Bytes taken in the ring by a record with a `len` byte payload. */
+#define GRFIFO_SPAN(len)                                                       \
+  ((GRFIFO_HDR + (uint32_t)(len) + (GRFIFO_ALIGN - 1)) &                       \
+   ~(uint32_t)(GRFIFO_ALIGN - 1))
+
+/**
+ * @brief  Declare a record FIFO type over a byte gfifo type.
+ *
+ * @param name  Suffix used to form the record FIFO type name.
+ * @param fifo  Name of a gfifo type declared with element type uint8_t.
+ *
+ * The generated type is:
+ *     grfifo_<name>_t   (an alias of gfifo_<fifo>_t)
+ *
+ * Records of up to size / 2 - GRFIFO_HDR bytes always fit once the FIFO is
+ * empty; larger ones may fail depending on the current write position.
+ * Thread safety is the one of gfifo_<fifo>_t (SPSC).
+ */
+#define DECLARE_GRFIFO_TYPE(name, fifo)                                        \
+  DECLARE_GRFIFO_TYPE_EX(name, fifo, uint32_t)
+
+/**
+ * @brief  DECLARE_GRFIFO_TYPE() for a byte gfifo type with a custom index
+ *         type (see DECLARE_GFIFO_TYPE_EX()).
+ *
+ * idx_t must be the index type the byte gfifo was declared with. Record
+ * lengths stay uint32_t; a record must still fit in the FIFO.
+ */
+#define DECLARE_GRFIFO_TYPE_EX(name, fifo, idx_t)                              \
+  typedef gfifo_##fifo##_t grfifo_##name##_t;                                  \
+                                                                               \
+  /**                                                                          \
+   * @brief Initialize record FIFO with user_provided buffer.                  \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param buf Buffer, GRFIFO_ALIGN aligned.                                  \
+   * @param size Buffer size in bytes, a power of two >= 2 * GRFIFO_HDR.       \
+   *                                                                           \
+   * @return true  Initialization succeeded.                                   \
+   * @return false Invalid size, NULL or misaligned buffer.                    \
+   */                                                                          \
+  static inline bool grfifo_##name##_init(grfifo_##name##_t *f, uint8_t *buf,  \
+                                          idx_t size) {                        \
+    if (((uintptr_t)buf & (GRFIFO_ALIGN - 1)) != 0 || size < 2 * GRFIFO_HDR) { \
+      return false;                                                            \
+    }                                                                          \
+    return gfifo_##fifo##_init(f, buf, size);                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Reserve room for a record and return its payload.                  \
+   *                                                                           \
+   * The caller writes up to len bytes at the returned pointer (e.g. frames a  \
+   * message in place) and publishes them with commit().                       \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param len Maximum payload length.                                        \
+   *                                                                           \
+   * @return Contiguous payload area of len bytes, NULL if it does not fit.    \
+   */                                                                          \
+  static inline uint8_t *grfifo_##name##_reserve(grfifo_##name##_t *f,         \
+                                                 uint32_t len) {               \
+    uint8_t *p1, *p2;                                                          \
+    idx_t l1, l2;                                                              \
+    if (len > f->cap - GRFIFO_HDR) {                                           \
+      return NULL;                                                             \
+    }                                                                          \
+    uint32_t need = GRFIFO_SPAN(len);                                          \
+    /* too little space even without padding: fail here, so a second           \
+     * reserve does not count the same push_fail again */                      \
+    if (gfifo_##fifo##_push_reserve(f, (idx_t)need, &p1, &l1, &p2, &l2) <      \
+        (idx_t)need) {                                                         \
+      return NULL;                                                             \
+    }                                                                          \
+    if (l1 >= need) {                                                          \
+      return p1 + GRFIFO_HDR;                                                  \
+    }                                                                          \
+    idx_t tail = (idx_t)(f->cap - (idx_t)(p1 - f->buf));                       \
+    if (gfifo_##fifo##_push_reserve(f, (idx_t)(tail + need), &p1, &l1, &p2,    \
+                                    &l2) < (idx_t)(tail + need)) {             \
+      return NULL;                                                             \
+    }                                                                          \
+    const uint32_t pad = GRFIFO_PAD;                                           \
+    memcpy(p1, &pad, sizeof(pad));                                             \
+    return p2 + GRFIFO_HDR;                                                    \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Publish a record previously obtained via reserve().                \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param p Payload pointer returned by reserve().                           \
+   * @param len Actual payload length, at most the reserved length.            \
+   *                                                                           \
+   * @return true  Record published.                                           \
+   * @return false len exceeds the free space.                                 \
+   */                                                                          \
+  static inline bool grfifo_##name##_commit(grfifo_##name##_t *f, uint8_t *p,  \
+                                            uint32_t len) {                    \
+    uint8_t *p1, *p2;                                                          \
+    idx_t l1, l2;                                                              \
+    idx_t skip = 0;                                                            \
+    gfifo_##fifo##_push_reserve(f, 0, &p1, &l1, &p2, &l2);                     \
+    if (p != p1 + GRFIFO_HDR) {                                                \
+      skip = (idx_t)(f->cap - (idx_t)(p1 - f->buf));                           \
+    }                                                                          \
+    memcpy(p - GRFIFO_HDR, &len, sizeof(len));                                 \
+    return gfifo_##fifo##_push_commit(f, (idx_t)(skip + GRFIFO_SPAN(len)));    \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push one record.                                                   \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param data Payload.                                                      \
+   * @param len Payload length in bytes.                                       \
+   *                                                                           \
+   * @return true  Record pushed.                                              \
+   * @return false Not enough contiguous free space.                           \
+   */                                                                          \
+  static inline bool grfifo_##name##_push_record(                              \
+      grfifo_##name##_t *f, const void *data, uint32_t len) {                  \
+    uint8_t *p = grfifo_##name##_reserve(f, len);                              \
+    if (p == NULL) {                                                           \
+      return false;                                                            \
+    }                                                                          \
+    memcpy(p, data, len);                                                      \
+    return grfifo_##name##_commit(f, p, len);                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Get the first record in place without removing it.                 \
+   *                                                                           \
+   * The payload stays valid until release_record() or pop_record().           \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param p Output payload pointer.                                          \
+   * @param len Output payload length.                                         \
+   *                                                                           \
+   * @return Number of ring bytes the record takes (including any padding      \
+   *         before it), 0 if the FIFO holds no record.                        \
+   */                                                                          \
+  static inline idx_t grfifo_##name##_peek_record(                             \
+      grfifo_##name##_t *f, const uint8_t **p, uint32_t *len) {                \
+    const uint8_t *p1, *p2;                                                    \
+    idx_t l1, l2;                                                              \
+    uint32_t n;                                                                \
+    idx_t skip = 0;                                                            \
+    if (gfifo_##fifo##_readable_spans(f, &p1, &l1, &p2, &l2) < GRFIFO_HDR) {   \
+      return 0;                                                                \
+    }                                                                          \
+    memcpy(&n, p1, sizeof(n));                                                 \
+    if (n == GRFIFO_PAD) {                                                     \
+      skip = l1;                                                               \
+      p1 = p2;                                                                 \
+      memcpy(&n, p1, sizeof(n));                                               \
+    }                                                                          \
+    *p = p1 + GRFIFO_HDR;                                                      \
+    *len = n;                                                                  \
+    return (idx_t)(skip + GRFIFO_SPAN(n));                                     \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Remove the first record without copying it.                        \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   *                                                                           \
+   * @return true  Record removed.                                             \
+   * @return false FIFO holds no record.                                       \
+   */                                                                          \
+  static inline bool grfifo_##name##_release_record(grfifo_##name##_t *f) {    \
+    const uint8_t *p;                                                          \
+    uint32_t len;                                                              \
+    idx_t n = grfifo_##name##_peek_record(f, &p, &len);                        \
+    return n > 0 && gfifo_##fifo##_release(f, n);                              \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop the first record into a caller buffer.                         \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param dst Destination buffer.                                            \
+   * @param size Size of dst in bytes.                                         \
+   * @param len Output payload length; set even when dst is too small.         \
+   *                                                                           \
+   * @return true  Record popped.                                              \
+   * @return false FIFO holds no record or dst is too small (the record        \
+   *               stays in the FIFO).                                         \
+   */                                                                          \
+  static inline bool grfifo_##name##_pop_record(                               \
+      grfifo_##name##_t *f, void *dst, uint32_t size, uint32_t *len) {         \
+    const uint8_t *p;                                                          \
+    idx_t n = grfifo_##name##_peek_record(f, &p, len);                         \
+    if (n == 0 || *len > size) {                                               \
+      return false;                                                            \
+    }                                                                          \
+    memcpy(dst, p, *len);                                                      \
+    return gfifo_##fifo##_release(f, n);                                       \
+  }
+
+#endif //! __GRFIFO_H__
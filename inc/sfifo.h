@@ -9,12 +9,22 @@
  * index wrapping via bit masking.
  *
  * Features:
- *   - Fixed capacity defined at compile time
+ *   - Fixed capacity defined at compile time; capacity and mask are
+ *     constant expressions, so no cap/msk fields are stored per instance
  *   - Lock‑free single‑producer / single‑consumer operation
  *   - Constant‑time push/pop/peek operations
  *   - Efficient bulk push/pop for contiguous or wrapped regions
+ *   - Partial bulk push/pop returning the number of elements moved
+ *   - In-place batch push/pop via callbacks, one index update per batch
+ *   - Zero-copy push via push_reserve/push_commit
+ *   - Zero-copy pop via readable_spans/release
  *   - Header‑only, fully inlined implementation
  *
+ * Layouts:
+ *   - DECLARE_SFIFO_TYPE():    all indices share one cache line
+ *   - DECLARE_SFIFO_TYPE_CL(): producer and consumer indices on separate
+ *                              cache lines, each side caching the other's
+ *
  * Usage:
  *   DECLARE_SFIFO_TYPE(byte, uint8_t, 1024);
  *   sfifo_byte_1024_t fifo;
@@ -36,6 +46,56 @@
 #include <stdint.h>
 #include <string.h>
 
+/**
+ * @brief Cache line size used by DECLARE_SFIFO_TYPE_CL().
+ */
+#ifndef SFIFO_CACHELINE
+#define SFIFO_CACHELINE 64
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define __SFIFO_ALIGNED(n) _Alignas(n)
+#else
+#define __SFIFO_ALIGNED(n) __attribute__((aligned(n)))
+#endif
+
+/*
+ * Struct layout and opposite-index caching for each layout.
+ *
+ * PACKED : indices share one cache line and are always read from the
+ *          shared fields.
+ * CL     : producer state and consumer state live on separate cache
+ *          lines. The producer keeps a private copy of o (oc) and the
+ *          consumer a private copy of i (ic); the shared index is only
+ *          reloaded when the copy says there is not enough space or data
+ *          for the request.
+ */
+#define __SFIFO_STRUCT_PACKED(name, type, size)                                \
+  typedef struct {                                                             \
+    type buf[size];                                                            \
+    volatile uint32_t i;                                                       \
+    volatile uint32_t o;                                                       \
+  } sfifo_##name##_##size##_t
+
+#define __SFIFO_CACHE_RESET_PACKED(f) ((void)0)
+#define __SFIFO_PROD_OUT_PACKED(f, size, in, need) ((f)->o)
+#define __SFIFO_CONS_IN_PACKED(f, size, out, need) ((f)->i)
+
+#define __SFIFO_STRUCT_CL(name, type, size)                                    \
+  typedef struct {                                                             \
+    __SFIFO_ALIGNED(SFIFO_CACHELINE) volatile uint32_t i;                      \
+    uint32_t oc;                                                               \
+    __SFIFO_ALIGNED(SFIFO_CACHELINE) volatile uint32_t o;                      \
+    uint32_t ic;                                                               \
+    __SFIFO_ALIGNED(SFIFO_CACHELINE) type buf[size];                           \
+  } sfifo_##name##_##size##_t
+
+#define __SFIFO_CACHE_RESET_CL(f) ((f)->oc = (f)->ic = 0)
+#define __SFIFO_PROD_OUT_CL(f, size, in, need)                                 \
+  (((size) - ((in) - (f)->oc) >= (need)) ? (f)->oc : ((f)->oc = (f)->o))
+#define __SFIFO_CONS_IN_CL(f, size, out, need)                                 \
+  ((((f)->ic - (out)) >= (need)) ? (f)->ic : ((f)->ic = (f)->i))
+
 /**
  * @brief Declare a static FIFO type with fixed capacity.
  *
@@ -51,20 +111,41 @@
  * @param size  FIFO capacity (must be power of 2)
  */
 #define DECLARE_SFIFO_TYPE(name, type, size)                                   \
+  __SFIFO_DECLARE(name, type, size, PACKED)
+
+/**
+ * @brief Declare a static FIFO type with cache-line separated indices.
+ *
+ * Same type name and API as DECLARE_SFIFO_TYPE(). The producer index and
+ * the consumer index are placed on separate SFIFO_CACHELINE aligned lines,
+ * and each side only re-reads the opposite index when its cached copy says
+ * the FIFO is full (producer) or empty (consumer).
+ *
+ * The indices are only volatile, without barriers, so like
+ * DECLARE_SFIFO_TYPE() this is for single-core use (e.g. ISR to task).
+ * For a FIFO shared between two cores use DECLARE_GFIFO_TYPE_ATOMIC_CL().
+ *
+ * @param name  Logical name of the FIFO type
+ * @param type  Element type stored in the FIFO
+ * @param size  FIFO capacity (must be power of 2)
+ */
+#define DECLARE_SFIFO_TYPE_CL(name, type, size)                                \
+  __SFIFO_DECLARE(name, type, size, CL)
+
+/*
+ * Common implementation behind the public DECLARE_SFIFO_TYPE* macros.
+ * `layout` selects the struct layout (see __SFIFO_STRUCT_<layout>).
+ */
+#define __SFIFO_DECLARE(name, type, size, layout)                              \
   _Static_assert(((size) & ((size) - 1)) == 0,                                 \
                  "sfifo size must be power of 2");                             \
-  typedef struct {                                                             \
-    type buf[size];                                                            \
-    uint32_t cap;                                                              \
-    uint32_t msk;                                                              \
-    volatile uint32_t i;                                                       \
-    volatile uint32_t o;                                                       \
-  } sfifo_##name##_##size##_t;                                                 \
+  __SFIFO_STRUCT_##layout(name, type, size);                                   \
                                                                                \
   /**                                                                          \
    * @brief Initialize FIFO state.                                             \
    *                                                                           \
-   * Sets read/write indices to zero and configures capacity and mask.         \
+   * Sets read/write indices to zero. Capacity and mask are compile-time       \
+   * constants derived from size, so they are not stored in the instance.      \
    * Must be called before any push/pop operations.                            \
    *                                                                           \
    * @param f Pointer to FIFO instance                                         \
@@ -76,8 +157,7 @@
       return false;                                                            \
     }                                                                          \
     f->i = f->o = 0;                                                           \
-    f->cap = size;                                                             \
-    f->msk = size - 1;                                                         \
+    __SFIFO_CACHE_RESET_##layout(f);                                           \
     return true;                                                               \
   }                                                                            \
                                                                                \
@@ -90,6 +170,7 @@
   static inline void sfifo_##name##_##size##_reset(                            \
       sfifo_##name##_##size##_t *f) {                                          \
     f->i = f->o = 0;                                                           \
+    __SFIFO_CACHE_RESET_##layout(f);                                           \
   }                                                                            \
                                                                                \
   /**                                                                          \
@@ -111,7 +192,7 @@
    */                                                                          \
   static inline bool sfifo_##name##_##size##_is_full(                          \
       const sfifo_##name##_##size##_t *f) {                                    \
-    return (f->i - f->o) == f->cap;                                            \
+    return (f->i - f->o) == (size);                                            \
   }                                                                            \
                                                                                \
   /**                                                                          \
@@ -133,11 +214,11 @@
    */                                                                          \
   static inline bool sfifo_##name##_##size##_push(                             \
       sfifo_##name##_##size##_t *f, const type *e) {                           \
-    uint32_t cnt = f->i - f->o;                                                \
-    if (cnt < f->cap) {                                                        \
-      uint32_t idx = f->i;                                                     \
-      f->buf[idx & f->msk] = *e;                                               \
-      f->i++;                                                                  \
+    uint32_t in = f->i;                                                        \
+    uint32_t cnt = in - __SFIFO_PROD_OUT_##layout(f, size, in, 1);             \
+    if (cnt < (size)) {                                                        \
+      f->buf[in & ((size) - 1)] = *e;                                          \
+      f->i = in + 1;                                                           \
       return true;                                                             \
     }                                                                          \
     return false;                                                              \
@@ -152,11 +233,11 @@
    */                                                                          \
   static inline bool sfifo_##name##_##size##_pop(sfifo_##name##_##size##_t *f, \
                                                  type *e) {                    \
-    uint32_t cnt = f->i - f->o;                                                \
+    uint32_t out = f->o;                                                       \
+    uint32_t cnt = __SFIFO_CONS_IN_##layout(f, size, out, 1) - out;            \
     if (cnt > 0) {                                                             \
-      uint32_t idx = f->o;                                                     \
-      *e = f->buf[idx & f->msk];                                               \
-      f->o++;                                                                  \
+      *e = f->buf[out & ((size) - 1)];                                         \
+      f->o = out + 1;                                                          \
       return true;                                                             \
     }                                                                          \
     return false;                                                              \
@@ -169,9 +250,10 @@
    */                                                                          \
   static inline bool sfifo_##name##_##size##_drop(                             \
       sfifo_##name##_##size##_t *f) {                                          \
-    uint32_t cnt = f->i - f->o;                                                \
+    uint32_t out = f->o;                                                       \
+    uint32_t cnt = __SFIFO_CONS_IN_##layout(f, size, out, 1) - out;            \
     if (cnt > 0) {                                                             \
-      f->o++;                                                                  \
+      f->o = out + 1;                                                          \
       return true;                                                             \
     }                                                                          \
     return false;                                                              \
@@ -190,7 +272,7 @@
     uint32_t idx;                                                              \
     if (cnt > 0) {                                                             \
       idx = f->o;                                                              \
-      *e = f->buf[idx & f->msk];                                               \
+      *e = f->buf[idx & ((size) - 1)];                                         \
       return true;                                                             \
     }                                                                          \
     return false;                                                              \
@@ -210,7 +292,7 @@
     uint32_t idx;                                                              \
     if (ofst < cnt) {                                                          \
       idx = f->o;                                                              \
-      *e = f->buf[(idx + ofst) & f->msk];                                      \
+      *e = f->buf[(idx + ofst) & ((size) - 1)];                                \
       return true;                                                             \
     }                                                                          \
     return false;                                                              \
@@ -230,9 +312,9 @@
   static inline bool sfifo_##name##_##size##_push_array(                       \
       sfifo_##name##_##size##_t *f, const type *arr, uint32_t len) {           \
     uint32_t in = *(volatile uint32_t *)&f->i;                                 \
-    uint32_t out = *(volatile uint32_t *)&f->o;                                \
-    uint32_t cap = f->cap;                                                     \
-    uint32_t msk = f->msk;                                                     \
+    uint32_t out = __SFIFO_PROD_OUT_##layout(f, size, in, len);                \
+    const uint32_t cap = (size);                                               \
+    const uint32_t msk = (size) - 1;                                           \
     uint32_t spc = cap - (in - out);                                           \
     if (len == 0) {                                                            \
       return true;                                                             \
@@ -264,10 +346,10 @@
    */                                                                          \
   static inline bool sfifo_##name##_##size##_pop_array(                        \
       sfifo_##name##_##size##_t *f, type *arr, uint32_t len) {                 \
-    uint32_t in = *(volatile uint32_t *)&f->i;                                 \
     uint32_t out = *(volatile uint32_t *)&f->o;                                \
-    uint32_t cap = f->cap;                                                     \
-    uint32_t msk = f->msk;                                                     \
+    uint32_t in = __SFIFO_CONS_IN_##layout(f, size, out, len);                 \
+    const uint32_t cap = (size);                                               \
+    const uint32_t msk = (size) - 1;                                           \
     uint32_t cnt = in - out;                                                   \
     if (len == 0) {                                                            \
       return true;                                                             \
@@ -284,6 +366,254 @@
     }                                                                          \
     *(volatile uint32_t *)&f->o = out + len;                                   \
     return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Push as many elements of an array as fit into FIFO.                \
+   *                                                                           \
+   * Copies min(len, free space) elements with at most two memcpy()            \
+   * operations instead of failing when the whole array does not fit.          \
+   *                                                                           \
+   * @param f FIFO instance                                                    \
+   * @param arr Input array                                                    \
+   * @param len Number of elements available in arr                            \
+   * @return Number of elements pushed                                         \
+   */                                                                          \
+  static inline uint32_t sfifo_##name##_##size##_push_some(                    \
+      sfifo_##name##_##size##_t *f, const type *arr, uint32_t len) {           \
+    uint32_t in = f->i;                                                        \
+    uint32_t out = __SFIFO_PROD_OUT_##layout(f, size, in, len);                \
+    const uint32_t cap = (size);                                               \
+    const uint32_t msk = (size) - 1;                                           \
+    uint32_t spc = cap - (in - out);                                           \
+    if (len > spc) {                                                           \
+      len = spc;                                                               \
+    }                                                                          \
+    if (len == 0) {                                                            \
+      return 0;                                                                \
+    }                                                                          \
+    uint32_t ofst = in & msk;                                                  \
+    uint32_t l2e = cap - ofst;                                                 \
+    uint32_t l1 = (len < l2e) ? len : l2e;                                     \
+    memcpy(&f->buf[ofst], arr, l1 * sizeof(type));                             \
+    if (len > l1) {                                                            \
+      memcpy(f->buf, &arr[l1], (len - l1) * sizeof(type));                     \
+    }                                                                          \
+    f->i = in + len;                                                           \
+    return len;                                                                \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop as many elements as available from FIFO.                       \
+   *                                                                           \
+   * Copies min(len, stored elements) elements with at most two memcpy()       \
+   * operations instead of failing when the FIFO holds fewer than len.         \
+   *                                                                           \
+   * @param f FIFO instance                                                    \
+   * @param arr Output array                                                   \
+   * @param len Capacity of arr in elements                                    \
+   * @return Number of elements popped                                         \
+   */                                                                          \
+  static inline uint32_t sfifo_##name##_##size##_pop_some(                     \
+      sfifo_##name##_##size##_t *f, type *arr, uint32_t len) {                 \
+    uint32_t out = f->o;                                                       \
+    uint32_t in = __SFIFO_CONS_IN_##layout(f, size, out, len);                 \
+    const uint32_t cap = (size);                                               \
+    const uint32_t msk = (size) - 1;                                           \
+    uint32_t cnt = in - out;                                                   \
+    if (len > cnt) {                                                           \
+      len = cnt;                                                               \
+    }                                                                          \
+    if (len == 0) {                                                            \
+      return 0;                                                                \
+    }                                                                          \
+    uint32_t ofst = out & msk;                                                 \
+    uint32_t l2e = cap - ofst;                                                 \
+    uint32_t l1 = (len < l2e) ? len : l2e;                                     \
+    memcpy(arr, &f->buf[ofst], l1 * sizeof(type));                             \
+    if (len > l1) {                                                            \
+      memcpy(&arr[l1], f->buf, (len - l1) * sizeof(type));                     \
+    }                                                                          \
+    f->o = out + len;                                                          \
+    return len;                                                                \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Callbacks used by push_batch()/pop_batch().                        \
+   *                                                                           \
+   * fill constructs one element in place and returns false to end the         \
+   * batch without publishing that slot. consume inspects one element and      \
+   * returns false to end the batch without consuming it.                      \
+   */                                                                          \
+  typedef bool (*sfifo_##name##_##size##_fill_fn)(type *e, void *ctx);         \
+  typedef bool (*sfifo_##name##_##size##_consume_fn)(const type *e,            \
+                                                     void *ctx);               \
+                                                                               \
+  /**                                                                          \
+   * @brief Push up to n elements constructed in place by a callback.          \
+   *                                                                           \
+   * The free space is computed once, fill() is called for each slot in        \
+   * order directly on buf, and the write index is published once for the      \
+   * whole batch.                                                              \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param n Maximum number of elements to push.                              \
+   * @param fill Callback constructing one element.                            \
+   * @param ctx Opaque pointer passed to fill.                                 \
+   *                                                                           \
+   * @return Number of elements pushed.                                        \
+   */                                                                          \
+  static inline uint32_t sfifo_##name##_##size##_push_batch(                   \
+      sfifo_##name##_##size##_t *f, uint32_t n,                                \
+      sfifo_##name##_##size##_fill_fn fill, void *ctx) {                       \
+    uint32_t in = f->i;                                                        \
+    uint32_t out = __SFIFO_PROD_OUT_##layout(f, size, in, n);                  \
+    uint32_t spc = (size) - (in - out);                                        \
+    uint32_t k;                                                                \
+    if (n > spc) {                                                             \
+      n = spc;                                                                 \
+    }                                                                          \
+    for (k = 0; k < n; k++) {                                                  \
+      if (!fill(&f->buf[(in + k) & ((size) - 1)], ctx)) {                      \
+        break;                                                                 \
+      }                                                                        \
+    }                                                                          \
+    if (k > 0) {                                                               \
+      f->i = in + k;                                                           \
+    }                                                                          \
+    return k;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Pop up to max elements, handing each one to a callback.            \
+   *                                                                           \
+   * The stored count is computed once, consume() is called for each element   \
+   * in order directly on buf, and the read index is published once for the    \
+   * whole batch.                                                              \
+   *                                                                           \
+   * @param f FIFO instance.                                                   \
+   * @param max Maximum number of elements to pop.                             \
+   * @param consume Callback consuming one element.                            \
+   * @param ctx Opaque pointer passed to consume.                              \
+   *                                                                           \
+   * @return Number of elements popped.                                        \
+   */                                                                          \
+  static inline uint32_t sfifo_##name##_##size##_pop_batch(                    \
+      sfifo_##name##_##size##_t *f, uint32_t max,                              \
+      sfifo_##name##_##size##_consume_fn consume, void *ctx) {                 \
+    uint32_t out = f->o;                                                       \
+    uint32_t cnt = __SFIFO_CONS_IN_##layout(f, size, out, max) - out;          \
+    uint32_t k;                                                                \
+    if (max > cnt) {                                                           \
+      max = cnt;                                                               \
+    }                                                                          \
+    for (k = 0; k < max; k++) {                                                \
+      if (!consume(&f->buf[(out + k) & ((size) - 1)], ctx)) {                  \
+        break;                                                                 \
+      }                                                                        \
+    }                                                                          \
+    if (k > 0) {                                                               \
+      f->o = out + k;                                                          \
+    }                                                                          \
+    return k;                                                                  \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Reserve writable regions for a zero-copy push.                     \
+   *                                                                           \
+   * Reserves min(want, free space) elements at the write position as up to    \
+   * two contiguous regions; the second one is only used when the              \
+   * reservation wraps and always starts at buf[0]. Publish the written        \
+   * elements with push_commit().                                              \
+   *                                                                           \
+   * @param f FIFO instance                                                    \
+   * @param want Number of elements requested                                  \
+   * @param p1 Output start of the first region                                \
+   * @param l1 Output length of the first region                               \
+   * @param p2 Output start of the second region, NULL if none                 \
+   * @param l2 Output length of the second region, 0 if none                   \
+   * @return Number of elements reserved (l1 + l2)                             \
+   */                                                                          \
+  static inline uint32_t sfifo_##name##_##size##_push_reserve(                 \
+      sfifo_##name##_##size##_t *f, uint32_t want, type **p1, uint32_t *l1,    \
+      type **p2, uint32_t *l2) {                                               \
+    uint32_t in = f->i;                                                        \
+    uint32_t out = __SFIFO_PROD_OUT_##layout(f, size, in, want);               \
+    uint32_t spc = (size) - (in - out);                                        \
+    uint32_t len = (want < spc) ? want : spc;                                  \
+    uint32_t ofst = in & ((size) - 1);                                         \
+    uint32_t l2e = (size) - ofst;                                              \
+    uint32_t n1 = (len < l2e) ? len : l2e;                                     \
+    *p1 = &f->buf[ofst];                                                       \
+    *l1 = n1;                                                                  \
+    *p2 = (len > n1) ? f->buf : NULL;                                          \
+    *l2 = len - n1;                                                            \
+    return len;                                                                \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Publish elements written into regions from push_reserve().         \
+   *                                                                           \
+   * @param f FIFO instance                                                    \
+   * @param n Number of elements to publish                                    \
+   * @return true if published, false if n exceeds the free space              \
+   */                                                                          \
+  static inline bool sfifo_##name##_##size##_push_commit(                      \
+      sfifo_##name##_##size##_t *f, uint32_t n) {                              \
+    uint32_t in = f->i;                                                        \
+    uint32_t out = __SFIFO_PROD_OUT_##layout(f, size, in, n);                  \
+    if (n > (size) - (in - out)) {                                             \
+      return false;                                                            \
+    }                                                                          \
+    f->i = in + n;                                                             \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Get the readable regions for a zero-copy pop.                      \
+   *                                                                           \
+   * Describes the stored elements as up to two contiguous regions; the        \
+   * second one is only used when the data wraps and always starts at          \
+   * buf[0]. The elements stay in the FIFO until release() is called.          \
+   *                                                                           \
+   * @param f FIFO instance                                                    \
+   * @param p1 Output start of the first region                                \
+   * @param l1 Output length of the first region                               \
+   * @param p2 Output start of the second region, NULL if none                 \
+   * @param l2 Output length of the second region, 0 if none                   \
+   * @return Number of readable elements (l1 + l2)                             \
+   */                                                                          \
+  static inline uint32_t sfifo_##name##_##size##_readable_spans(               \
+      sfifo_##name##_##size##_t *f, const type **p1, uint32_t *l1,             \
+      const type **p2, uint32_t *l2) {                                         \
+    uint32_t out = f->o;                                                       \
+    uint32_t len = __SFIFO_CONS_IN_##layout(f, size, out, (size)) - out;       \
+    uint32_t ofst = out & ((size) - 1);                                        \
+    uint32_t l2e = (size) - ofst;                                              \
+    uint32_t n1 = (len < l2e) ? len : l2e;                                     \
+    *p1 = &f->buf[ofst];                                                       \
+    *l1 = n1;                                                                  \
+    *p2 = (len > n1) ? f->buf : NULL;                                          \
+    *l2 = len - n1;                                                            \
+    return len;                                                                \
+  }                                                                            \
+                                                                               \
+  /**                                                                          \
+   * @brief Consume elements previously obtained via readable_spans().         \
+   *                                                                           \
+   * @param f FIFO instance                                                    \
+   * @param n Number of elements to consume                                    \
+   * @return true if consumed, false if FIFO does not contain n elements       \
+   */                                                                          \
+  static inline bool sfifo_##name##_##size##_release(                          \
+      sfifo_##name##_##size##_t *f, uint32_t n) {                              \
+    uint32_t out = f->o;                                                       \
+    uint32_t in = __SFIFO_CONS_IN_##layout(f, size, out, n);                   \
+    if (n > in - out) {                                                        \
+      return false;                                                            \
+    }                                                                          \
+    f->o = out + n;                                                            \
+    return true;                                                               \
   }
 
 #endif //! __SFIFO_H__
@@ -0,0 +1,77 @@
+#include "gfifo.hpp"
+#include <cstdio>
+#include <memory>
+#include <string>
+
+/*
+ * Smoke test of gfifo.hpp, built with -std=c++17: both ring flavours with
+ * a trivially copyable, a move-only and a heap-owning element type. Exits
+ * non-zero on the first failed check.
+ */
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__,        \
+                         __LINE__, #cond);                                     \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+static int test_trivial()
+{
+    gfifo::ring<int, 8> q;
+    int arr[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    int out[8] = {};
+    int e = 0;
+
+    static_assert(gfifo::ring<int, 8>::capacity() == 8);
+    CHECK(q.push_some(arr, 8) == 8);
+    CHECK(q.full() && !q.try_push(e));
+    CHECK(q.try_pop(e) && e == 0);
+    CHECK(q.pop_some(out, 8) == 7 && out[6] == 7);
+    CHECK(q.empty());
+    return 0;
+}
+
+static int test_move_only()
+{
+    gfifo::ring<std::unique_ptr<int>> q(4);
+    std::unique_ptr<int> out;
+
+    CHECK(q.capacity() == 4);
+    CHECK(q.try_push(std::make_unique<int>(42)));
+    CHECK(q.emplace(new int(7)));
+    CHECK(q.try_pop(out) && *out == 42);
+    CHECK(q.pop() && q.empty());
+    return 0;
+}
+
+static int test_string()
+{
+    gfifo::ring<std::string, 4> q;
+    std::string s(64, 'y');
+    std::string out;
+
+    CHECK(q.try_push(std::move(s)));
+    CHECK(q.emplace(16, 'x'));
+    CHECK(q.size() == 2);
+    CHECK(q.try_pop(out) && out == std::string(64, 'y'));
+    CHECK(q.try_pop(out) && out == std::string(16, 'x'));
+    CHECK(q.try_push(out));
+    q.clear();
+    CHECK(q.empty());
+    return 0;
+}
+
+int main()
+{
+    if (test_trivial() || test_move_only() || test_string())
+    {
+        return 1;
+    }
+    std::printf("test_gfifo_hpp: ok\n");
+    return 0;
+}
@@ -0,0 +1,764 @@
+/* the Linux headers need it under -std=c11, see their Requires line */
+#define _GNU_SOURCE
+
+/* small enough that the streaming kernels run on the test buffers */
+#define GFIFO_COPY_NT_THRESHOLD 64
+#include "gfifo_copy.h"
+#define GFIFO_MEMCPY(dst, src, n) gfifo_copy((dst), (src), (n))
+
+#define GFIFO_ENTER_CRITICAL() critical++
+#define GFIFO_EXIT_CRITICAL() critical--
+static int critical;
+
+#include "gfifo.h"
+#include "gfifo_alloc.h"
+#include "gfifo_bcast.h"
+#include "gfifo_elastic.h"
+#include "gfifo_io.h"
+#include "gfifo_lanes.h"
+#include "gfifo_mirror.h"
+#include "gfifo_mpmc.h"
+#include "gfifo_mpsc.h"
+#include "gfifo_mux.h"
+#include "gfifo_pool.h"
+#include "gfifo_shm.h"
+#include "gfifo_uring.h"
+#include "gfifo_wait.h"
+#include "grfifo.h"
+#include "sfifo.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Include and instantiate every C header, then push and pop a few elements
+ * through each generated type. Catches what the demos never compile; `make
+ * test` builds it with -Wall -Wextra, once more with GFIFO_CFG_STATS and
+ * GFIFO_CFG_LATENCY. Exits non-zero on the first failed check.
+ */
+
+#define SIZE (64)
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+/* gfifo.h */
+DECLARE_GFIFO_TYPE(plain, uint32_t);
+DECLARE_GFIFO_TYPE_CL(plain_cl, uint32_t);
+DECLARE_GFIFO_TYPE_EX(plain16, uint32_t, uint16_t);
+DECLARE_GFIFO_TYPE_CL_EX(plain16_cl, uint32_t, uint16_t);
+DECLARE_GFIFO_TYPE_ISR(isr, uint32_t);
+DECLARE_GFIFO_TYPE_ISR_EX(isr16, uint32_t, uint16_t);
+DECLARE_GFIFO_TYPE_ATOMIC(u32, uint32_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL(u32_cl, uint32_t);
+DECLARE_GFIFO_TYPE_ATOMIC_EX(u32_16, uint32_t, uint16_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL_EX(u32_16_cl, uint32_t, uint16_t);
+DECLARE_GFIFO_TYPE_LOSSY(lossy, uint32_t);
+DECLARE_GFIFO_TYPE_ATOMIC_CL(byte, uint8_t);
+DECLARE_GFIFO_TYPE_ATOMIC_EX(byte16, uint8_t, uint16_t);
+
+/* sfifo.h */
+DECLARE_SFIFO_TYPE(u32, uint32_t, 64);
+DECLARE_SFIFO_TYPE_CL(u32_cl, uint32_t, 64);
+
+/* companion headers */
+DECLARE_GFIFO_ALLOC(u32_cl, uint32_t);
+DECLARE_GFIFO_BCAST_TYPE(b2, uint32_t, 2);
+DECLARE_GFIFO_ELASTIC_TYPE(e, u32_cl, uint32_t);
+DECLARE_GFIFO_IO(byte);
+DECLARE_GFIFO_IO_EX(byte16, uint16_t);
+DECLARE_GFIFO_LANES_TYPE(l2, u32, uint32_t, 2);
+DECLARE_GFIFO_TYPE_MIRRORED(mir, uint8_t);
+DECLARE_GFIFO_TYPE_ATOMIC_MIRRORED(mir_atomic, uint8_t);
+DECLARE_GFIFO_MPMC_TYPE(mpmc, uint32_t);
+DECLARE_GFIFO_MPSC_TYPE(mpsc, uint32_t);
+DECLARE_GFIFO_MUX_TYPE(m3, u32_cl, uint32_t, 3);
+DECLARE_GFIFO_POOL(p, uint32_t, 16);
+DECLARE_GFIFO_POOL_EX(p8, uint32_t, 16, uint8_t);
+DECLARE_GFIFO_POOL(p10, uint32_t, 10);
+DECLARE_GFIFO_TYPE_SHM(shm, uint32_t);
+DECLARE_GFIFO_URING(byte);
+DECLARE_GFIFO_WAIT(u32, uint32_t);
+DECLARE_GRFIFO_TYPE(rec, byte);
+DECLARE_GRFIFO_TYPE_EX(rec16, byte16, uint16_t);
+
+static uint32_t buf32[3 * SIZE];
+static _Alignas(GRFIFO_ALIGN) uint8_t buf8[4096];
+
+/* push 1..n one by one, pop them back in order */
+#define ROUND_TRIP(prefix, f, n)                                               \
+    do                                                                         \
+    {                                                                          \
+        uint32_t __e;                                                          \
+        for (uint32_t __k = 1; __k <= (n); __k++)                              \
+        {                                                                      \
+            CHECK(prefix##_push((f), &__k));                                   \
+        }                                                                      \
+        for (uint32_t __k = 1; __k <= (n); __k++)                              \
+        {                                                                      \
+            CHECK(prefix##_pop((f), &__e) && __e == __k);                      \
+        }                                                                      \
+        CHECK(!prefix##_pop((f), &__e));                                       \
+    } while (0)
+
+#define GFIFO_ROUND_TRIP(name)                                                 \
+    do                                                                         \
+    {                                                                          \
+        gfifo_##name##_t f;                                                    \
+        CHECK(gfifo_##name##_init(&f, buf32, SIZE));                           \
+        ROUND_TRIP(gfifo_##name, &f, SIZE);                                    \
+    } while (0)
+
+/* push_batch/pop_batch callbacks: produce and expect next, up to stop */
+typedef struct
+{
+    uint32_t next;
+    uint32_t stop;
+} batch_ctx_t;
+
+static bool batch_fill(uint32_t *e, void *ctx)
+{
+    batch_ctx_t *c = ctx;
+
+    if (c->next == c->stop)
+    {
+        return false;
+    }
+    *e = c->next++;
+    return true;
+}
+
+static bool batch_consume(const uint32_t *e, void *ctx)
+{
+    batch_ctx_t *c = ctx;
+
+    if (*e == c->stop || *e != c->next)
+    {
+        return false;
+    }
+    c->next++;
+    return true;
+}
+
+static int test_batch(void)
+{
+    gfifo_u32_t f;
+    batch_ctx_t c;
+    uint32_t arr[SIZE], e;
+
+    /* start 4 slots before the end of buf */
+    CHECK(gfifo_u32_init(&f, buf32, SIZE));
+    CHECK(gfifo_u32_push_array(&f, arr, SIZE - 4));
+    CHECK(gfifo_u32_pop_array(&f, arr, SIZE - 4));
+
+    /* fill stops at 3: nothing is published for that slot */
+    c = (batch_ctx_t){0, 3};
+    CHECK(gfifo_u32_push_batch(&f, 10, batch_fill, &c) == 3);
+    CHECK(gfifo_u32_count(&f) == 3);
+
+    /* continues in the slot fill declined, and wraps the end of buf */
+    c.stop = 100;
+    CHECK(gfifo_u32_push_batch(&f, 10, batch_fill, &c) == 10);
+    CHECK(gfifo_u32_count(&f) == 13 && c.next == 13);
+
+    /* consume stops at 7: that element stays in the FIFO */
+    c = (batch_ctx_t){0, 7};
+    CHECK(gfifo_u32_pop_batch(&f, 13, batch_consume, &c) == 7);
+    CHECK(gfifo_u32_count(&f) == 6);
+    CHECK(gfifo_u32_peek(&f, &e) && e == 7);
+
+    c.stop = 100;
+    CHECK(gfifo_u32_pop_batch(&f, 100, batch_consume, &c) == 6);
+    CHECK(c.next == 13 && gfifo_u32_is_empty(&f));
+    CHECK(gfifo_u32_pop_batch(&f, 1, batch_consume, &c) == 0);
+    return 0;
+}
+
+static int test_gfifo(void)
+{
+    GFIFO_ROUND_TRIP(plain);
+    GFIFO_ROUND_TRIP(plain_cl);
+    GFIFO_ROUND_TRIP(plain16);
+    GFIFO_ROUND_TRIP(plain16_cl);
+    GFIFO_ROUND_TRIP(isr);
+    GFIFO_ROUND_TRIP(isr16);
+    GFIFO_ROUND_TRIP(u32);
+    GFIFO_ROUND_TRIP(u32_cl);
+    GFIFO_ROUND_TRIP(u32_16);
+    GFIFO_ROUND_TRIP(u32_16_cl);
+    GFIFO_ROUND_TRIP(lossy);
+
+    gfifo_isr_t isr;
+    uint32_t e = 1;
+    CHECK(gfifo_isr_init(&isr, buf32, SIZE));
+    CHECK(gfifo_isr_push_critical(&isr, &e) && critical == 0);
+    CHECK(gfifo_isr_pop_critical(&isr, &e) && e == 1 && critical == 0);
+
+    /* overwrite keeps the newest SIZE elements and reports the rest */
+    gfifo_lossy_t lossy;
+    uint32_t arr[SIZE + 8], lost = 0;
+    CHECK(gfifo_lossy_init(&lossy, buf32, SIZE));
+    for (uint32_t k = 0; k < 2 * SIZE; k++)
+    {
+        lost += gfifo_lossy_push_overwrite(&lossy, &k);
+    }
+    CHECK(lost == SIZE);
+    CHECK(gfifo_lossy_pop(&lossy, &e) && e == SIZE);
+
+    /* a batch longer than the FIFO keeps only its tail */
+    for (uint32_t k = 0; k < SIZE + 8; k++)
+    {
+        arr[k] = 1000 + k;
+    }
+    CHECK(gfifo_lossy_push_array_overwrite(&lossy, arr, SIZE + 8) ==
+          SIZE - 1 + 8);
+    CHECK(gfifo_lossy_pop(&lossy, &e) && e == 1008);
+    return 0;
+}
+
+/* snapshot counters of the test_headers_cfg build */
+static int test_stats(void)
+{
+    gfifo_u32_t f;
+    gfifo_lossy_t lossy;
+    gfifo_stats_t st;
+    gfifo_latency_t lt;
+    uint32_t arr[SIZE], e = 0;
+
+    CHECK(gfifo_u32_init(&f, buf32, SIZE));
+    CHECK(gfifo_u32_push(&f, &e));
+    CHECK(gfifo_u32_push_array(&f, arr, SIZE - 1));
+    CHECK(!gfifo_u32_push(&f, &e));
+    CHECK(gfifo_u32_pop(&f, &e));
+    CHECK(gfifo_u32_pop_some(&f, arr, SIZE) == SIZE - 1);
+    CHECK(!gfifo_u32_pop(&f, &e));
+#ifdef GFIFO_CFG_STATS
+    CHECK(gfifo_u32_stats(&f, &st));
+    CHECK(st.pushes == SIZE && st.push_fail == 1 && st.hwm == SIZE);
+    CHECK(st.bytes_in == SIZE * sizeof(uint32_t) && st.lost == 0);
+    CHECK(st.pops == SIZE && st.pop_empty == 1);
+    CHECK(st.bytes_out == SIZE * sizeof(uint32_t));
+#else
+    CHECK(!gfifo_u32_stats(&f, &st) && st.pushes == 0);
+#endif
+#ifdef GFIFO_CFG_LATENCY
+    CHECK(gfifo_u32_latency(&f, &lt));
+    CHECK(lt.samples == 2 && lt.max >= lt.p50);
+#else
+    CHECK(!gfifo_u32_latency(&f, &lt) && lt.samples == 0);
+#endif
+
+    /*
+     * Fill with stamped pushes, then overwrite all of it: the stamps of the
+     * overwritten elements must be dropped instead of blocking the ones
+     * pushed after them.
+     */
+    CHECK(gfifo_lossy_init(&lossy, buf32, SIZE));
+    for (uint32_t k = 0; k < SIZE; k++)
+    {
+        CHECK(gfifo_lossy_push(&lossy, &k));
+    }
+    for (uint32_t k = 0; k < SIZE; k++)
+    {
+        CHECK(gfifo_lossy_push_overwrite(&lossy, &k) == 1);
+    }
+    CHECK(gfifo_lossy_pop_some(&lossy, arr, SIZE) == SIZE);
+    for (uint32_t k = 0; k < 8; k++)
+    {
+        CHECK(gfifo_lossy_push(&lossy, &k));
+        CHECK(gfifo_lossy_pop(&lossy, &e) && e == k);
+    }
+#ifdef GFIFO_CFG_STATS
+    CHECK(gfifo_lossy_stats(&lossy, &st));
+    CHECK(st.pushes == 2 * SIZE + 8 && st.lost == SIZE && st.hwm == SIZE);
+    CHECK(st.pops == SIZE + 8 && st.pop_empty == 0);
+#endif
+#ifdef GFIFO_CFG_LATENCY
+    CHECK(gfifo_lossy_latency(&lossy, &lt));
+    CHECK(lt.samples == 8);
+#endif
+    return 0;
+}
+
+static int test_sfifo(void)
+{
+    sfifo_u32_64_t s;
+    sfifo_u32_cl_64_t s_cl;
+
+    CHECK(sfifo_u32_64_init(&s));
+    ROUND_TRIP(sfifo_u32_64, &s, 64);
+    CHECK(sfifo_u32_cl_64_init(&s_cl));
+    ROUND_TRIP(sfifo_u32_cl_64, &s_cl, 64);
+    return 0;
+}
+
+static int test_copy(void)
+{
+    uint8_t src[300], dst[300];
+
+    for (int k = 0; k < 300; k++)
+    {
+        src[k] = (uint8_t)k;
+    }
+    CHECK(gfifo_copy(dst, src, sizeof(src)) == dst);
+    CHECK(memcmp(dst, src, sizeof(src)) == 0);
+    CHECK(gfifo_copy_backend() != NULL);
+    return 0;
+}
+
+static int test_alloc(void)
+{
+    gfifo_u32_cl_t *f = gfifo_u32_cl_create(SIZE, GFIFO_ALLOC_POPULATE);
+
+    CHECK(f != NULL);
+    ROUND_TRIP(gfifo_u32_cl, f, SIZE);
+    gfifo_u32_cl_destroy(f);
+    return 0;
+}
+
+static int test_bcast(void)
+{
+    gfifo_bcast_b2_t b;
+    uint32_t arr[SIZE];
+    uint32_t e;
+
+    CHECK(gfifo_bcast_b2_init(&b, buf32, SIZE, GFIFO_BCAST_BLOCK));
+    for (uint32_t k = 0; k < SIZE; k++)
+    {
+        arr[k] = k;
+    }
+    CHECK(gfifo_bcast_b2_push_array(&b, arr, SIZE));
+    CHECK(!gfifo_bcast_b2_push(&b, arr));
+    for (uint32_t r = 0; r < 2; r++)
+    {
+        memset(arr, 0, sizeof(arr));
+        CHECK(gfifo_bcast_b2_pop_some(&b, r, arr, SIZE) == SIZE);
+        CHECK(arr[SIZE - 1] == SIZE - 1);
+    }
+    CHECK(gfifo_bcast_b2_push(&b, arr));
+
+    /* Reader 1 lags behind a full ring: the next push detaches it. */
+    CHECK(gfifo_bcast_b2_init(&b, buf32, SIZE, GFIFO_BCAST_DETACH));
+    for (uint32_t k = 0; k < SIZE; k++)
+    {
+        arr[k] = k;
+    }
+    CHECK(gfifo_bcast_b2_push_array(&b, arr, SIZE));
+    CHECK(gfifo_bcast_b2_pop_some(&b, 0, arr, SIZE) == SIZE);
+    e = SIZE;
+    CHECK(gfifo_bcast_b2_push(&b, &e));
+    CHECK(!gfifo_bcast_b2_is_attached(&b, 1));
+    CHECK(gfifo_bcast_b2_count(&b, 1) == 0);
+    CHECK(!gfifo_bcast_b2_pop(&b, 1, &e));
+    gfifo_bcast_b2_attach(&b, 1);
+    CHECK(gfifo_bcast_b2_is_attached(&b, 1));
+    CHECK(gfifo_bcast_b2_count(&b, 1) == 0);
+    CHECK(gfifo_bcast_b2_is_attached(&b, 0));
+    CHECK(gfifo_bcast_b2_count(&b, 0) == 1);
+    CHECK(gfifo_bcast_b2_pop(&b, 0, &e) && e == SIZE);
+    e = SIZE + 1;
+    CHECK(gfifo_bcast_b2_push(&b, &e));
+    for (uint32_t r = 0; r < 2; r++)
+    {
+        e = 0;
+        CHECK(gfifo_bcast_b2_pop(&b, r, &e) && e == SIZE + 1);
+        CHECK(gfifo_bcast_b2_count(&b, r) == 0);
+    }
+    return 0;
+}
+
+static int test_elastic(void)
+{
+    gfifo_elastic_e_t q;
+    uint32_t e;
+
+    CHECK(gfifo_elastic_e_init(&q, 4, SIZE));
+    for (uint32_t k = 0; k < 3; k++)
+    {
+        CHECK(gfifo_elastic_e_push(&q, &k));
+    }
+    CHECK(gfifo_elastic_e_pop(&q, &e) && e == 0);
+
+    /* 1..4 fill the first segment, 5 is pushed into a new one. */
+    for (uint32_t k = 3; k < SIZE; k++)
+    {
+        CHECK(gfifo_elastic_e_push(&q, &k));
+        if (k == 4)
+        {
+            CHECK(gfifo_elastic_e_capacity(&q) == 4);
+        }
+        else if (k == 5)
+        {
+            CHECK(gfifo_elastic_e_capacity(&q) == 8);
+        }
+    }
+    CHECK(gfifo_elastic_e_capacity(&q) >= SIZE - 1);
+    CHECK(!gfifo_elastic_e_shrink(&q));
+    for (uint32_t k = 1; k < SIZE; k++)
+    {
+        CHECK(gfifo_elastic_e_pop(&q, &e) && e == k);
+    }
+    CHECK(gfifo_elastic_e_is_empty(&q));
+
+    /* Idle: shrink back to min_cap, then round trip through it. */
+    CHECK(gfifo_elastic_e_shrink(&q));
+    CHECK(gfifo_elastic_e_capacity(&q) == 4);
+    CHECK(!gfifo_elastic_e_shrink(&q));
+    for (uint32_t k = 0; k < 4; k++)
+    {
+        CHECK(gfifo_elastic_e_push(&q, &k));
+    }
+    CHECK(gfifo_elastic_e_capacity(&q) == 4);
+    for (uint32_t k = 0; k < 4; k++)
+    {
+        CHECK(gfifo_elastic_e_pop(&q, &e) && e == k);
+    }
+    CHECK(gfifo_elastic_e_is_empty(&q));
+    gfifo_elastic_e_destroy(&q);
+    return 0;
+}
+
+static int test_io(void)
+{
+    int fds[2];
+    gfifo_byte_t tx, rx;
+    gfifo_byte16_t rx16;
+    static uint8_t tx_buf[SIZE], rx_buf[SIZE];
+    static uint8_t rx16_buf[SIZE];
+    const char msg[] = "gfifo_io";
+    char out[sizeof(msg)];
+
+    CHECK(pipe(fds) == 0);
+    CHECK(gfifo_byte_init(&tx, tx_buf, SIZE));
+    CHECK(gfifo_byte_init(&rx, rx_buf, SIZE));
+    CHECK(gfifo_byte16_init(&rx16, rx16_buf, SIZE));
+    CHECK(gfifo_byte_push_array(&tx, (const uint8_t *)msg, sizeof(msg)));
+    CHECK(gfifo_byte_drain_to_fd(&tx, fds[1]) == (ssize_t)sizeof(msg));
+    CHECK(gfifo_byte_fill_from_fd(&rx, fds[0]) == (ssize_t)sizeof(msg));
+    CHECK(gfifo_byte_pop_array(&rx, (uint8_t *)out, sizeof(msg)));
+    CHECK(memcmp(out, msg, sizeof(msg)) == 0);
+
+    CHECK(write(fds[1], msg, sizeof(msg)) == (ssize_t)sizeof(msg));
+    CHECK(gfifo_byte16_fill_from_fd(&rx16, fds[0]) == (ssize_t)sizeof(msg));
+    CHECK(gfifo_byte16_count(&rx16) == sizeof(msg));
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+}
+
+static int test_lanes(void)
+{
+    gfifo_lanes_l2_t q;
+    uint32_t e, lane;
+
+    CHECK(gfifo_lanes_l2_init(&q, buf32, SIZE));
+    e = 7;
+    CHECK(gfifo_lanes_l2_push(&q, 1, &e));
+    e = 3;
+    CHECK(gfifo_lanes_l2_push(&q, 0, &e));
+    CHECK(gfifo_lanes_l2_pop(&q, &e, &lane) && lane == 0 && e == 3);
+    CHECK(gfifo_lanes_l2_pop(&q, &e, &lane) && lane == 1 && e == 7);
+    CHECK(!gfifo_lanes_l2_pop(&q, &e, &lane));
+    return 0;
+}
+
+static int test_mirror(void)
+{
+    gfifo_mir_t f;
+    gfifo_mir_atomic_t fa;
+    uint32_t page = (uint32_t)sysconf(_SC_PAGESIZE);
+    uint8_t e = 5;
+
+    CHECK(gfifo_mir_init_mirrored(&f, page));
+    CHECK(gfifo_mir_push(&f, &e) && gfifo_mir_pop(&f, &e) && e == 5);
+    gfifo_mir_destroy_mirrored(&f);
+    CHECK(gfifo_mir_atomic_init_mirrored(&fa, page));
+    CHECK(gfifo_mir_atomic_push(&fa, &e) && gfifo_mir_atomic_pop(&fa, &e));
+    gfifo_mir_atomic_destroy_mirrored(&fa);
+    return 0;
+}
+
+static int test_mpmc(void)
+{
+    static gfifo_mpmc_slot_t slots[SIZE];
+    gfifo_mpmc_t f;
+
+    CHECK(gfifo_mpmc_init(&f, slots, SIZE));
+    ROUND_TRIP(gfifo_mpmc, &f, SIZE);
+    return 0;
+}
+
+static int test_mpsc(void)
+{
+    gfifo_mpsc_t f;
+
+    CHECK(gfifo_mpsc_init(&f, buf32, SIZE));
+    ROUND_TRIP(gfifo_mpsc, &f, SIZE);
+    return 0;
+}
+
+static int test_mux(void)
+{
+    gfifo_mux_m3_t m;
+    uint32_t arr[SIZE], from;
+
+    CHECK(gfifo_mux_m3_init(&m, buf32, SIZE));
+    arr[0] = 9;
+    CHECK(gfifo_mux_m3_push(&m, 2, arr));
+    CHECK(gfifo_mux_m3_pop_some(&m, arr, SIZE, &from) == 1);
+    CHECK(from == 2 && arr[0] == 9);
+    CHECK(gfifo_mux_m3_pop_some(&m, arr, SIZE, &from) == 0);
+    return 0;
+}
+
+static int test_pool(void)
+{
+    static gfifo_pool_p_t p;
+    static gfifo_pool_p8_t p8;
+    uint32_t *obj[16];
+
+    gfifo_pool_p_init(&p);
+    for (int k = 0; k < 16; k++)
+    {
+        CHECK((obj[k] = gfifo_pool_p_alloc(&p)) != NULL);
+    }
+    CHECK(gfifo_pool_p_alloc(&p) == NULL);
+    for (int k = 0; k < 16; k++)
+    {
+        CHECK(gfifo_pool_p_free(&p, obj[k]));
+    }
+    CHECK(gfifo_pool_p_available(&p) == 16);
+
+    gfifo_pool_p8_init(&p8);
+    CHECK((obj[0] = gfifo_pool_p8_alloc(&p8)) != NULL);
+    CHECK(gfifo_pool_p8_free(&p8, obj[0]));
+
+    /* n = 10 gets a 16-entry free list: double frees past n still fail */
+    static gfifo_pool_p10_t p10;
+    uint32_t s[16];
+    gfifo_pool_p10_init(&p10);
+    for (int k = 0; k < 10; k++)
+    {
+        CHECK((obj[k] = gfifo_pool_p10_alloc(&p10)) != NULL);
+    }
+    CHECK(gfifo_pool_p10_alloc(&p10) == NULL);
+    for (int k = 0; k < 10; k++)
+    {
+        CHECK(gfifo_pool_p10_free(&p10, obj[k]));
+    }
+    CHECK(!gfifo_pool_p10_free(&p10, obj[0]));
+    CHECK(gfifo_pool_p10_available(&p10) == 10);
+
+    CHECK(gfifo_pool_p10_alloc_some(&p10, s, 16) == 10);
+    CHECK(gfifo_pool_p10_free_some(&p10, s, 10) == 10);
+    CHECK(gfifo_pool_p10_free_some(&p10, s, 1) == 0);
+    CHECK(gfifo_pool_p10_available(&p10) == 10);
+    CHECK(gfifo_pool_p10_alloc_some(&p10, s, 3) == 3);
+    CHECK(gfifo_pool_p10_free_some(&p10, s, 6) == 3);
+    CHECK(gfifo_pool_p10_available(&p10) == 10);
+    return 0;
+}
+
+static int test_shm(void)
+{
+    char path[64];
+    gfifo_shm_t *tx, *rx;
+    uint32_t e = 11;
+
+    snprintf(path, sizeof(path), "/gfifo_test_%d", (int)getpid());
+    CHECK((tx = gfifo_shm_shm_create(path, SIZE)) != NULL);
+    CHECK((rx = gfifo_shm_shm_attach(path)) != NULL);
+    CHECK(gfifo_shm_push(tx, &e));
+    e = 0;
+    CHECK(gfifo_shm_pop(rx, &e) && e == 11);
+    gfifo_shm_shm_detach(rx);
+    gfifo_shm_shm_detach(tx);
+    CHECK(gfifo_shm_unlink(path) == 0);
+    return 0;
+}
+
+static int test_uring(void)
+{
+    gfifo_uring_t u;
+    gfifo_uring_drain_t d;
+    gfifo_byte_t f;
+    static uint8_t fifo_buf[SIZE];
+    const char msg[] = "gfifo_uring";
+    char out[sizeof(msg)];
+    int fds[2];
+
+    /* io_uring may be disabled (kernel.io_uring_disabled, seccomp) */
+    if (!gfifo_uring_init(&u, 8))
+    {
+        printf("test_headers: io_uring unavailable, skipped\n");
+        return 0;
+    }
+    CHECK(pipe(fds) == 0);
+    CHECK(gfifo_byte_init(&f, fifo_buf, SIZE));
+    CHECK(gfifo_byte_push_array(&f, (const uint8_t *)msg, sizeof(msg)));
+    gfifo_byte_uring_attach(&d, &f, fds[1], -1);
+    CHECK(gfifo_byte_uring_drain(&u, &d) == 1);
+    CHECK(gfifo_uring_submit(&u, 1) >= 0);
+    CHECK(gfifo_uring_reap(&u) == 1);
+    CHECK(gfifo_byte_is_empty(&f));
+    CHECK(read(fds[0], out, sizeof(out)) == (ssize_t)sizeof(msg));
+    CHECK(memcmp(out, msg, sizeof(msg)) == 0);
+    close(fds[0]);
+    close(fds[1]);
+    gfifo_uring_exit(&u);
+    return 0;
+}
+
+static gfifo_u32_t wait_fifo;
+static gfifo_wait_t wait_state;
+
+/* pushes one element after the consumer had time to park */
+static void *wait_producer(void *arg)
+{
+    uint32_t e = 5;
+
+    (void)arg;
+    usleep(10000);
+    gfifo_u32_push_timed(&wait_fifo, &wait_state, &e, GFIFO_WAIT_FOREVER);
+    return NULL;
+}
+
+static int test_wait(void)
+{
+    gfifo_u32_t f;
+    gfifo_wait_t w;
+    pthread_t t;
+    uint32_t e = 4;
+
+    CHECK(gfifo_u32_init(&f, buf32, SIZE));
+    CHECK(gfifo_wait_init(&w));
+    CHECK(!gfifo_u32_pop_timed(&f, &w, &e, 1000000));
+    CHECK(gfifo_u32_push_timed(&f, &w, &e, GFIFO_WAIT_FOREVER));
+    e = 0;
+    gfifo_u32_pop_wait(&f, &w, &e);
+    CHECK(e == 4);
+    gfifo_wait_destroy(&w);
+
+    /* a finite timeout whose deadline does not fit waits like FOREVER */
+    CHECK(gfifo_u32_init(&wait_fifo, buf32, SIZE));
+    CHECK(gfifo_wait_init(&wait_state));
+    CHECK(pthread_create(&t, NULL, wait_producer, NULL) == 0);
+    CHECK(gfifo_u32_pop_timed(&wait_fifo, &wait_state, &e,
+                              GFIFO_WAIT_FOREVER - 1));
+    CHECK(e == 5);
+    pthread_join(t, NULL);
+    gfifo_wait_destroy(&wait_state);
+    return 0;
+}
+
+static int test_grfifo(void)
+{
+    grfifo_rec_t f;
+    grfifo_rec16_t f16;
+    const char msg[] = "record";
+    char out[16];
+    uint32_t len;
+
+    CHECK(grfifo_rec_init(&f, buf8, sizeof(buf8)));
+    CHECK(grfifo_rec_push_record(&f, msg, sizeof(msg)));
+    CHECK(grfifo_rec_pop_record(&f, out, sizeof(out), &len));
+    CHECK(len == sizeof(msg) && memcmp(out, msg, len) == 0);
+
+    CHECK(grfifo_rec16_init(&f16, buf8, sizeof(buf8)));
+    CHECK(grfifo_rec16_push_record(&f16, msg, sizeof(msg)));
+    CHECK(grfifo_rec16_pop_record(&f16, out, sizeof(out), &len));
+    CHECK(len == sizeof(msg));
+    return 0;
+}
+
+/* payload length and byte j of record s in test_grfifo_wrap */
+#define REC_LEN(s) (1 + (s) * 13 % 48)
+#define REC_BYTE(s, j) ((uint8_t)((s) * 31 + (j)))
+
+/*
+ * Records of 1 to 48 bytes through a 128-byte ring: the producer keeps it
+ * as full as it goes, so records regularly do not fit before the end of
+ * buf and are placed at buf[0] behind a padding marker.
+ */
+static int test_grfifo_wrap(void)
+{
+    static _Alignas(GRFIFO_ALIGN) uint8_t ring[128];
+    grfifo_rec_t f;
+    uint8_t rec[48];
+    const uint8_t *p;
+    uint32_t pushed = 0, popped = 0, fails = 0, pads = 0, len;
+
+    CHECK(grfifo_rec_init(&f, ring, sizeof(ring)));
+    while (popped < 300)
+    {
+        for (uint32_t j = 0; j < REC_LEN(pushed); j++)
+        {
+            rec[j] = REC_BYTE(pushed, j);
+        }
+        if (grfifo_rec_push_record(&f, rec, REC_LEN(pushed)))
+        {
+            pushed++;
+            continue;
+        }
+        /* a record of at most size / 2 - GRFIFO_HDR fits once empty */
+        CHECK(pushed > popped);
+        fails++;
+
+        uint32_t n = grfifo_rec_peek_record(&f, &p, &len);
+        CHECK(len == REC_LEN(popped));
+        pads += n > GRFIFO_SPAN(len);
+        CHECK(((uintptr_t)p & (GRFIFO_ALIGN - 1)) == 0);
+        CHECK(grfifo_rec_pop_record(&f, rec, sizeof(rec), &len));
+        CHECK(len == REC_LEN(popped));
+        for (uint32_t j = 0; j < len; j++)
+        {
+            CHECK(rec[j] == REC_BYTE(popped, j));
+        }
+        popped++;
+    }
+    CHECK(pads > 0);
+
+    /* reserve the maximum, commit less */
+    while (grfifo_rec_release_record(&f))
+    {
+    }
+    uint8_t *w = grfifo_rec_reserve(&f, 48);
+    CHECK(w != NULL);
+    memset(w, 0xab, 5);
+    CHECK(grfifo_rec_commit(&f, w, 5));
+    CHECK(grfifo_rec_pop_record(&f, rec, sizeof(rec), &len) && len == 5);
+    CHECK(rec[0] == 0xab && rec[4] == 0xab);
+    CHECK(!grfifo_rec_pop_record(&f, rec, sizeof(rec), &len));
+
+#ifdef GFIFO_CFG_STATS
+    /* one push_fail per failed push_record, padded or not */
+    gfifo_stats_t st;
+    CHECK(gfifo_byte_stats(&f, &st) && st.push_fail == fails);
+#else
+    (void)fails;
+#endif
+    return 0;
+}
+
+int main(void)
+{
+    if (test_gfifo() || test_batch() || test_stats() || test_sfifo() ||
+        test_copy() || test_alloc() || test_bcast() || test_elastic() ||
+        test_io() || test_lanes() || test_mirror() || test_mpmc() ||
+        test_mpsc() || test_mux() || test_pool() || test_shm() ||
+        test_uring() || test_wait() || test_grfifo() || test_grfifo_wrap())
+    {
+        return 1;
+    }
+    printf("test_headers: ok\n");
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "gfifo_lanes.h"
+#include <stdio.h>
+
+/*
+ * Scheduling checks for gfifo_lanes.h: strict priority, weighted rounds
+ * and weighted lanes next to strict ones. Single threaded, exits non-zero
+ * on the first failed check.
+ */
+
+#define LANE_SIZE (64)
+
+#define CHECK(cond)                                                            \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                    #cond);                                                    \
+            return 1;                                                          \
+        }                                                                      \
+    } while (0)
+
+DECLARE_GFIFO_TYPE_ATOMIC(u32, uint32_t);
+DECLARE_GFIFO_LANES_TYPE(q3, u32, uint32_t, 3);
+
+static uint32_t storage[3 * LANE_SIZE];
+static gfifo_lanes_q3_t q;
+
+static void fill(uint32_t lane, uint32_t n)
+{
+    for (uint32_t k = 0; k < n; k++)
+    {
+        gfifo_lanes_q3_push(&q, lane, &k);
+    }
+}
+
+/* lane 0 is strict and always served first */
+static int test_strict(void)
+{
+    uint32_t e, lane;
+
+    CHECK(gfifo_lanes_q3_init(&q, storage, LANE_SIZE));
+    fill(2, 4);
+    fill(0, 4);
+    for (int k = 0; k < 4; k++)
+    {
+        CHECK(gfifo_lanes_q3_pop(&q, &e, &lane));
+        CHECK(lane == 0);
+    }
+    CHECK(gfifo_lanes_q3_pop(&q, &e, &lane));
+    CHECK(lane == 2);
+    return 0;
+}
+
+/* two busy weighted lanes share the consumer 3:1 */
+static int test_weighted(void)
+{
+    uint32_t e, lane, served[3] = {0};
+
+    CHECK(gfifo_lanes_q3_init(&q, storage, LANE_SIZE));
+    gfifo_lanes_q3_set_weight(&q, 0, 3);
+    gfifo_lanes_q3_set_weight(&q, 1, 1);
+    fill(0, LANE_SIZE);
+    fill(1, LANE_SIZE);
+    for (int k = 0; k < 40; k++)
+    {
+        CHECK(gfifo_lanes_q3_pop(&q, &e, &lane));
+        served[lane]++;
+    }
+    CHECK(served[0] == 30 && served[1] == 10);
+    return 0;
+}
+
+/*
+ * A weighted lane above a strict lane that never runs empty: the strict
+ * lane gets one turn per round instead of holding the consumer until it
+ * drains, i.e. one turn after every 8 elements of lane 0.
+ */
+static int test_weighted_over_strict(void)
+{
+    uint32_t e, lane, served[3] = {0};
+    uint32_t arr[LANE_SIZE];
+    uint32_t pops = 0;
+
+    CHECK(gfifo_lanes_q3_init(&q, storage, LANE_SIZE));
+    gfifo_lanes_q3_set_weight(&q, 0, 8);
+    fill(0, 32);
+    fill(1, 1);
+    while (served[0] < 32 && pops < 1000)
+    {
+        CHECK(gfifo_lanes_q3_pop(&q, &e, &lane));
+        served[lane]++;
+        pops++;
+        fill(1, lane == 1);
+    }
+    CHECK(pops == 35 && served[1] == 3);
+
+    /* same with pop_some, a strict turn is one batch */
+    CHECK(gfifo_lanes_q3_init(&q, storage, LANE_SIZE));
+    gfifo_lanes_q3_set_weight(&q, 0, 8);
+    fill(0, 32);
+    fill(1, 16);
+    served[0] = served[1] = pops = 0;
+    while (served[0] < 32 && pops < 1000)
+    {
+        uint32_t n = gfifo_lanes_q3_pop_some(&q, arr, 16, &lane);
+        CHECK(n > 0);
+        CHECK(lane != 0 || n == 8);
+        served[lane] += n;
+        pops++;
+        if (lane == 1)
+        {
+            fill(1, n);
+        }
+    }
+    CHECK(pops == 7 && served[1] == 48);
+    return 0;
+}
+
+int main(void)
+{
+    if (test_strict() || test_weighted() || test_weighted_over_strict())
+    {
+        return 1;
+    }
+    printf("test_lanes: ok\n");
+    return 0;
+}